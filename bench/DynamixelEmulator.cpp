@@ -0,0 +1,282 @@
+#include "DynamixelEmulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Protocol 2.0 X-series control table (XM430-W350)
+static const EmulatedItem control_table[] = {
+    {"Model_Number", 0, 2},
+    {"Model_Information", 2, 4},
+    {"Firmware_Version", 6, 1},
+    {"ID", 7, 1},
+    {"Baud_Rate", 8, 1},
+    {"Return_Delay_Time", 9, 1},
+    {"Drive_Mode", 10, 1},
+    {"Operating_Mode", 11, 1},
+    {"Secondary_ID", 12, 1},
+    {"Protocol_Type", 13, 1},
+    {"Homing_Offset", 20, 4},
+    {"Moving_Threshold", 24, 4},
+    {"Temperature_Limit", 31, 1},
+    {"Max_Voltage_Limit", 32, 2},
+    {"Min_Voltage_Limit", 34, 2},
+    {"PWM_Limit", 36, 2},
+    {"Current_Limit", 38, 2},
+    {"Velocity_Limit", 44, 4},
+    {"Max_Position_Limit", 48, 4},
+    {"Min_Position_Limit", 52, 4},
+    {"Shutdown", 63, 1},
+    {"Torque_Enable", 64, 1},
+    {"LED", 65, 1},
+    {"Status_Return_Level", 68, 1},
+    {"Registered_Instruction", 69, 1},
+    {"Hardware_Error_Status", 70, 1},
+    {"Velocity_I_Gain", 76, 2},
+    {"Velocity_P_Gain", 78, 2},
+    {"Position_D_Gain", 80, 2},
+    {"Position_I_Gain", 82, 2},
+    {"Position_P_Gain", 84, 2},
+    {"Feedforward_2nd_Gain", 88, 2},
+    {"Feedforward_1st_Gain", 90, 2},
+    {"Bus_Watchdog", 98, 1},
+    {"Goal_PWM", 100, 2},
+    {"Goal_Current", 102, 2},
+    {"Goal_Velocity", 104, 4},
+    {"Profile_Acceleration", 108, 4},
+    {"Profile_Velocity", 112, 4},
+    {"Goal_Position", 116, 4},
+    {"Realtime_Tick", 120, 2},
+    {"Moving", 122, 1},
+    {"Moving_Status", 123, 1},
+    {"Present_PWM", 124, 2},
+    {"Present_Current", 126, 2},
+    {"Present_Velocity", 128, 4},
+    {"Present_Position", 132, 4},
+    {"Velocity_Trajectory", 136, 4},
+    {"Position_Trajectory", 140, 4},
+    {"Present_Input_Voltage", 144, 2},
+    {"Present_Temperature", 146, 1},
+    {"Indirect_Address_1", 168, 2},
+    {"Indirect_Data_1", 224, 1},
+    {"Indirect_Address_29", 578, 2},
+    {"Indirect_Data_29", 634, 1},
+};
+
+static constexpr uint16_t EEPROM_END = 64;
+static constexpr uint16_t INDIRECT_ADDRESS_1 = 168;
+static constexpr uint16_t INDIRECT_DATA_1 = 224;
+static constexpr uint16_t INDIRECT_ADDRESS_29 = 578;
+static constexpr uint16_t INDIRECT_DATA_29 = 634;
+static constexpr uint16_t INDIRECT_SLOTS = 28;
+
+DynamixelEmulator::DynamixelEmulator()
+    : instant_motion_(false)
+{
+}
+
+const EmulatedItem *DynamixelEmulator::getControlTable(size_t &num_items)
+{
+    num_items = sizeof(control_table) / sizeof(control_table[0]);
+    return control_table;
+}
+
+const EmulatedItem *DynamixelEmulator::findItem(const char *name)
+{
+    for (const auto &item : control_table)
+    {
+        if (std::strcmp(item.name, name) == 0)
+        {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+void DynamixelEmulator::clear()
+{
+    motors_.clear();
+}
+
+void DynamixelEmulator::addMotor(uint8_t id)
+{
+    if (motors_.size() <= id)
+    {
+        motors_.resize(id + 1);
+    }
+    motors_[id].reset(new Motor());
+    Motor &m = *motors_[id];
+    std::memset(m.table, 0, sizeof(m.table));
+    m.position = POSITION_CENTER;
+
+    writeValue(id, 0, 2, MODEL_NUMBER);
+    writeValue(id, 6, 1, 45);
+    writeValue(id, 7, 1, id);
+    writeValue(id, 8, 1, 1);   // 57600 bps
+    writeValue(id, 9, 1, 250); // 500 usec
+    writeValue(id, 11, 1, 3);  // position control
+    writeValue(id, 31, 1, 80);
+    writeValue(id, 32, 2, 160);
+    writeValue(id, 34, 2, 95);
+    writeValue(id, 36, 2, 885);
+    writeValue(id, 38, 2, 1193);
+    writeValue(id, 44, 4, 200);
+    writeValue(id, 48, 4, 4095);
+    writeValue(id, 52, 4, 0);
+    writeValue(id, 63, 1, 52);
+    writeValue(id, 68, 1, 2);
+    writeValue(id, 76, 2, 1920);
+    writeValue(id, 78, 2, 100);
+    writeValue(id, 84, 2, 800);
+    writeValue(id, 116, 4, POSITION_CENTER);
+    writeValue(id, 132, 4, POSITION_CENTER);
+    writeValue(id, 144, 2, 120);
+    writeValue(id, 146, 1, 30);
+    for (uint16_t i = 0; i < INDIRECT_SLOTS; i++)
+    {
+        writeValue(id, INDIRECT_ADDRESS_1 + 2 * i, 2, INDIRECT_DATA_1 + i);
+        writeValue(id, INDIRECT_ADDRESS_29 + 2 * i, 2, INDIRECT_DATA_29 + i);
+    }
+}
+
+bool DynamixelEmulator::hasMotor(uint8_t id) const
+{
+    return motor(id) != nullptr;
+}
+
+DynamixelEmulator::Motor *DynamixelEmulator::motor(uint8_t id) const
+{
+    return (id < motors_.size()) ? motors_[id].get() : nullptr;
+}
+
+uint16_t DynamixelEmulator::resolve(const Motor &m, uint16_t address) const
+{
+    uint16_t table_address;
+    if (address >= INDIRECT_DATA_1 && address < INDIRECT_DATA_1 + INDIRECT_SLOTS)
+    {
+        table_address = INDIRECT_ADDRESS_1 + 2 * (address - INDIRECT_DATA_1);
+    }
+    else if (address >= INDIRECT_DATA_29 && address < INDIRECT_DATA_29 + INDIRECT_SLOTS)
+    {
+        table_address = INDIRECT_ADDRESS_29 + 2 * (address - INDIRECT_DATA_29);
+    }
+    else
+    {
+        return address;
+    }
+    uint16_t target = m.table[table_address] | (m.table[table_address + 1] << 8);
+    return (target < CONTROL_TABLE_SIZE) ? target : address;
+}
+
+bool DynamixelEmulator::read(uint8_t id, uint16_t address, uint16_t length, uint8_t *data) const
+{
+    const Motor *m = motor(id);
+    if (m == nullptr || address + length > CONTROL_TABLE_SIZE)
+    {
+        return false;
+    }
+    for (uint16_t i = 0; i < length; i++)
+    {
+        data[i] = m->table[resolve(*m, address + i)];
+    }
+    return true;
+}
+
+bool DynamixelEmulator::write(uint8_t id, uint16_t address, uint16_t length, const uint8_t *data)
+{
+    Motor *m = motor(id);
+    if (m == nullptr || address + length > CONTROL_TABLE_SIZE)
+    {
+        return false;
+    }
+    bool torque = m->table[64] != 0;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        uint16_t target = resolve(*m, address + i);
+        bool eeprom = (target < EEPROM_END) ||
+                      (target >= INDIRECT_ADDRESS_1 && target < INDIRECT_ADDRESS_1 + 2 * INDIRECT_SLOTS) ||
+                      (target >= INDIRECT_ADDRESS_29 && target < INDIRECT_ADDRESS_29 + 2 * INDIRECT_SLOTS);
+        if (torque && eeprom)
+        {
+            return false;
+        }
+    }
+    for (uint16_t i = 0; i < length; i++)
+    {
+        m->table[resolve(*m, address + i)] = data[i];
+    }
+    return true;
+}
+
+uint32_t DynamixelEmulator::readValue(uint8_t id, uint16_t address, uint16_t length) const
+{
+    uint8_t data[4] = {0, 0, 0, 0};
+    read(id, address, std::min<uint16_t>(length, 4), data);
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+bool DynamixelEmulator::writeValue(uint8_t id, uint16_t address, uint16_t length, uint32_t value)
+{
+    uint8_t data[4] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+    return write(id, address, std::min<uint16_t>(length, 4), data);
+}
+
+void DynamixelEmulator::setInstantMotion(bool instant)
+{
+    instant_motion_ = instant;
+}
+
+void DynamixelEmulator::step(double dt)
+{
+    const double value_per_rpm = POSITION_RANGE / 60.0;
+    for (size_t id = 0; id < motors_.size(); id++)
+    {
+        Motor *m = motors_[id].get();
+        if (m == nullptr)
+        {
+            continue;
+        }
+        uint16_t realtime_tick = (uint16_t)(readValue(id, 120, 2) + (uint32_t)(dt * 1000.0));
+        writeValue(id, 120, 2, realtime_tick);
+
+        double velocity = 0.0; // [value/sec]
+        int16_t current = 0;
+        if (m->table[64] != 0)
+        {
+            uint8_t mode = m->table[11];
+            int32_t velocity_limit = (int32_t)readValue(id, 44, 4);
+            double max_velocity = velocity_limit * VELOCITY_UNIT * value_per_rpm;
+            if (mode == 1)
+            {
+                // velocity control
+                int32_t goal = (int32_t)readValue(id, 104, 4);
+                goal = std::max(-velocity_limit, std::min(velocity_limit, goal));
+                velocity = goal * VELOCITY_UNIT * value_per_rpm;
+            }
+            else if (mode == 0)
+            {
+                // current control: the current is followed, the joint is held
+                current = (int16_t)readValue(id, 102, 2);
+            }
+            else
+            {
+                // position control: move at the velocity limit towards the goal
+                double goal = (int32_t)readValue(id, 116, 4);
+                double delta = instant_motion_ ? goal - m->position
+                                               : std::max(-max_velocity * dt, std::min(max_velocity * dt, goal - m->position));
+                velocity = (dt > 0.0) ? delta / dt : 0.0;
+            }
+            if (mode != 0)
+            {
+                current = (int16_t)(velocity / (max_velocity + 1.0) * 100.0);
+            }
+        }
+        m->position += velocity * dt;
+
+        int32_t present_velocity = (int32_t)std::lround(velocity / (VELOCITY_UNIT * value_per_rpm));
+        writeValue(id, 132, 4, (uint32_t)(int32_t)std::lround(m->position));
+        writeValue(id, 128, 4, (uint32_t)present_velocity);
+        writeValue(id, 126, 2, (uint16_t)current);
+        writeValue(id, 122, 1, (velocity != 0.0) ? 1 : 0);
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Control table item of the emulated model.
+ */
+struct EmulatedItem
+{
+    const char *name; ///< Name of the item
+    uint16_t address; ///< Address in the control table
+    uint16_t length;  ///< Size of the item [byte]
+};
+
+/**
+ * @brief Register level emulation of X-series Dynamixels (Protocol 2.0, XM430-W350 control table).
+ *
+ * Holds the control table of each emulated motor, resolves Indirect Address
+ * mappings, rejects EEPROM writes while the torque is on, and moves the motors
+ * with a simple kinematic model in step().
+ */
+class DynamixelEmulator
+{
+public:
+    static constexpr uint16_t MODEL_NUMBER = 1020;      ///< XM430-W350
+    static constexpr size_t CONTROL_TABLE_SIZE = 662;   ///< Up to Indirect_Data_56
+    static constexpr int32_t POSITION_CENTER = 2048;    ///< Position value of 0 [rad]
+    static constexpr int32_t POSITION_RANGE = 4096;     ///< Position values per turn
+    static constexpr double VELOCITY_UNIT = 0.229;      ///< [rpm] per velocity value
+    static constexpr double CURRENT_UNIT = 2.69;        ///< [mA] per current value
+
+    /**
+     * @brief Constructor for the emulator class (no motors).
+     */
+    DynamixelEmulator();
+
+    /**
+     * @brief Returns the control table of the emulated model.
+     *
+     * @param num_items Output: Number of items
+     */
+    static const EmulatedItem *getControlTable(size_t &num_items);
+
+    /**
+     * @brief Returns the control table item of the given name, or nullptr.
+     */
+    static const EmulatedItem *findItem(const char *name);
+
+    /**
+     * @brief Removes all motors.
+     */
+    void clear();
+
+    /**
+     * @brief Adds a motor with the factory default control table.
+     */
+    void addMotor(uint8_t id);
+
+    /**
+     * @brief Returns true if a motor with the ID exists.
+     */
+    bool hasMotor(uint8_t id) const;
+
+    /**
+     * @brief Reads bytes from the control table (Indirect Data is resolved).
+     *
+     * @return true Successful
+     * @return false No such motor, or out of the control table
+     */
+    bool read(uint8_t id, uint16_t address, uint16_t length, uint8_t *data) const;
+
+    /**
+     * @brief Writes bytes to the control table (Indirect Data is resolved).
+     *
+     * @return true Successful
+     * @return false No such motor, out of the control table, or EEPROM write with torque on
+     */
+    bool write(uint8_t id, uint16_t address, uint16_t length, const uint8_t *data);
+
+    /**
+     * @brief Reads a little endian value (length 1, 2 or 4).
+     */
+    uint32_t readValue(uint8_t id, uint16_t address, uint16_t length) const;
+
+    /**
+     * @brief Writes a little endian value (length 1, 2 or 4).
+     */
+    bool writeValue(uint8_t id, uint16_t address, uint16_t length, uint32_t value);
+
+    /**
+     * @brief Makes position controlled motors reach the goal in the next step (for latency measurement).
+     */
+    void setInstantMotion(bool instant);
+
+    /**
+     * @brief Advances the motion of every motor.
+     *
+     * @param dt Elapsed time [sec]
+     */
+    void step(double dt);
+
+private:
+    struct Motor
+    {
+        uint8_t table[CONTROL_TABLE_SIZE];
+        double position; ///< Present position (value, not rounded)
+    };
+
+    Motor *motor(uint8_t id) const;
+    uint16_t resolve(const Motor &m, uint16_t address) const;
+
+    std::vector<std::unique_ptr<Motor>> motors_; ///< Indexed by ID
+    bool instant_motion_;
+};
@@ -0,0 +1,379 @@
+#include "MockDynamixelWorkbench.h"
+
+#include "dynamixel_workbench_toolbox/dynamixel_workbench.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    struct SyncHandler
+    {
+        uint16_t address;
+        uint16_t length;
+        std::vector<uint8_t> data; ///< Last sync read, length bytes for each ID
+        std::vector<uint8_t> ids;  ///< IDs of the last sync read
+    };
+
+    DynamixelEmulator bus;
+    std::vector<SyncHandler> sync_write_handlers;
+    std::vector<SyncHandler> sync_read_handlers;
+    std::vector<ControlItem> control_items;
+    uint32_t port_baud_rate = 0;
+
+    const uint8_t BROADCAST_ID = 0xFE;
+
+    const char *mock_log = "[MockDynamixelWorkbench] failed";
+    const char *mock_succeeded_log = "[MockDynamixelWorkbench] succeeded";
+
+    bool fail(const char **log)
+    {
+        if (log != NULL)
+        {
+            *log = mock_log;
+        }
+        return false;
+    }
+
+    // The toolbox also reports success through log, and the caller may print it
+    bool succeed(const char **log)
+    {
+        if (log != NULL)
+        {
+            *log = mock_succeeded_log;
+        }
+        return true;
+    }
+
+    const ModelInfo &modelInfo()
+    {
+        static ModelInfo info = [] {
+            ModelInfo m;
+            m.rpm = DynamixelEmulator::VELOCITY_UNIT;
+            m.value_of_min_radian_position = 0;
+            m.value_of_zero_radian_position = DynamixelEmulator::POSITION_CENTER;
+            m.value_of_max_radian_position = DynamixelEmulator::POSITION_RANGE - 1;
+            m.min_radian = -3.14159265;
+            m.max_radian = 3.14159265;
+            return m;
+        }();
+        return info;
+    }
+
+    const ControlItem *controlItem(const char *item_name)
+    {
+        if (control_items.empty())
+        {
+            size_t num_items = 0;
+            const EmulatedItem *table = DynamixelEmulator::getControlTable(num_items);
+            control_items.resize(num_items);
+            for (size_t i = 0; i < num_items; i++)
+            {
+                control_items[i].address = table[i].address;
+                control_items[i].item_name = table[i].name;
+                control_items[i].item_name_length = std::strlen(table[i].name);
+                control_items[i].data_length = table[i].length;
+            }
+        }
+        for (const auto &item : control_items)
+        {
+            if (std::strcmp(item.item_name, item_name) == 0)
+            {
+                return &item;
+            }
+        }
+        return NULL;
+    }
+}
+
+DynamixelEmulator &mockDynamixelBus()
+{
+    return bus;
+}
+
+void resetMockDynamixelBus()
+{
+    bus.clear();
+    sync_write_handlers.clear();
+    sync_read_handlers.clear();
+}
+
+// DynamixelDriver
+
+DynamixelDriver::DynamixelDriver()
+{
+}
+
+DynamixelDriver::~DynamixelDriver()
+{
+}
+
+bool DynamixelDriver::init(const char *, uint32_t baud_rate, const char **)
+{
+    port_baud_rate = baud_rate;
+    return true;
+}
+
+bool DynamixelDriver::setBaudrate(uint32_t baud_rate, const char **log)
+{
+    port_baud_rate = baud_rate;
+    return succeed(log);
+}
+
+uint32_t DynamixelDriver::getBaudrate(void)
+{
+    return port_baud_rate;
+}
+
+float DynamixelDriver::getProtocolVersion(void)
+{
+    return 2.0f;
+}
+
+bool DynamixelDriver::ping(uint8_t id, uint16_t *get_model_number, const char **log)
+{
+    if (!bus.hasMotor(id))
+    {
+        return fail(log);
+    }
+    *get_model_number = DynamixelEmulator::MODEL_NUMBER;
+    return true;
+}
+
+const ControlItem *DynamixelDriver::getItemInfo(uint8_t id, const char *item_name, const char **log)
+{
+    const ControlItem *item = bus.hasMotor(id) ? controlItem(item_name) : NULL;
+    if (item == NULL)
+    {
+        fail(log);
+    }
+    return item;
+}
+
+const ModelInfo *DynamixelDriver::getModelInfo(uint8_t, const char **)
+{
+    return &modelInfo();
+}
+
+bool DynamixelDriver::writeRegister(uint8_t id, uint16_t address, uint16_t length, uint8_t *data, const char **log)
+{
+    if (id == BROADCAST_ID)
+    {
+        // no status packet is returned, so failures are not reported
+        for (int i = 0; i < BROADCAST_ID; i++)
+        {
+            if (bus.hasMotor((uint8_t)i))
+            {
+                bus.write((uint8_t)i, address, length, data);
+            }
+        }
+        return succeed(log);
+    }
+    return bus.write(id, address, length, data) || fail(log);
+}
+
+bool DynamixelDriver::readRegister(uint8_t id, uint16_t address, uint16_t length, uint32_t *data, const char **log)
+{
+    if (length > 4 || !bus.hasMotor(id))
+    {
+        return fail(log);
+    }
+    *data = bus.readValue(id, address, length);
+    return true;
+}
+
+uint8_t DynamixelDriver::getTheNumberOfSyncWriteHandler(void)
+{
+    return sync_write_handlers.size();
+}
+
+uint8_t DynamixelDriver::getTheNumberOfSyncReadHandler(void)
+{
+    return sync_read_handlers.size();
+}
+
+bool DynamixelDriver::addSyncWriteHandler(uint16_t address, uint16_t length, const char **log)
+{
+    if (sync_write_handlers.size() >= 5)
+    {
+        return fail(log);
+    }
+    sync_write_handlers.push_back(SyncHandler{address, length, {}, {}});
+    return succeed(log);
+}
+
+bool DynamixelDriver::syncWrite(uint8_t index, uint8_t *id, uint8_t id_num, int32_t *data, uint8_t data_num_for_each_id, const char **log)
+{
+    if (index >= sync_write_handlers.size())
+    {
+        return fail(log);
+    }
+    const SyncHandler &handler = sync_write_handlers[index];
+    uint8_t param[4 * 256];
+    for (size_t i = 0; i < id_num; i++)
+    {
+        // each value is sent as 4 bytes, the packet carries the first length bytes
+        for (size_t v = 0; v < data_num_for_each_id; v++)
+        {
+            uint32_t value = (uint32_t)data[i * data_num_for_each_id + v];
+            for (size_t b = 0; b < 4; b++)
+            {
+                param[v * 4 + b] = (uint8_t)(value >> (8 * b));
+            }
+        }
+        if (!bus.write(id[i], handler.address, handler.length, param))
+        {
+            return fail(log);
+        }
+    }
+    return true;
+}
+
+bool DynamixelDriver::addSyncReadHandler(uint16_t address, uint16_t length, const char **log)
+{
+    if (sync_read_handlers.size() >= 5)
+    {
+        return fail(log);
+    }
+    sync_read_handlers.push_back(SyncHandler{address, length, {}, {}});
+    return succeed(log);
+}
+
+bool DynamixelDriver::syncRead(uint8_t index, uint8_t *id, uint8_t id_num, const char **log)
+{
+    if (index >= sync_read_handlers.size())
+    {
+        return fail(log);
+    }
+    SyncHandler &handler = sync_read_handlers[index];
+    handler.ids.assign(id, id + id_num);
+    handler.data.resize((size_t)id_num * handler.length);
+    for (size_t i = 0; i < id_num; i++)
+    {
+        if (!bus.read(id[i], handler.address, handler.length, &handler.data[i * handler.length]))
+        {
+            return fail(log);
+        }
+    }
+    return true;
+}
+
+bool DynamixelDriver::getSyncReadData(uint8_t index, uint8_t *id, uint8_t id_num, uint16_t address, uint16_t length, int32_t *data, const char **log)
+{
+    if (index >= sync_read_handlers.size())
+    {
+        return fail(log);
+    }
+    const SyncHandler &handler = sync_read_handlers[index];
+    if (address < handler.address || address + length > handler.address + handler.length)
+    {
+        return fail(log);
+    }
+    for (size_t i = 0; i < id_num; i++)
+    {
+        // IDs are usually requested in the order they were read
+        size_t slot = (i < handler.ids.size() && handler.ids[i] == id[i]) ? i : 0;
+        while (slot < handler.ids.size() && handler.ids[slot] != id[i])
+        {
+            slot++;
+        }
+        if (slot == handler.ids.size())
+        {
+            return fail(log);
+        }
+        // like GroupSyncRead::getData, the value is not sign extended
+        const uint8_t *p = &handler.data[slot * handler.length + (address - handler.address)];
+        uint32_t value = 0;
+        for (size_t b = 0; b < length && b < 4; b++)
+        {
+            value |= (uint32_t)p[b] << (8 * b);
+        }
+        data[i] = (int32_t)value;
+    }
+    return true;
+}
+
+// DynamixelWorkbench
+
+DynamixelWorkbench::DynamixelWorkbench()
+{
+}
+
+DynamixelWorkbench::~DynamixelWorkbench()
+{
+}
+
+bool DynamixelWorkbench::torqueOn(uint8_t id, const char **log)
+{
+    return bus.writeValue(id, 64, 1, 1) || fail(log);
+}
+
+bool DynamixelWorkbench::torqueOff(uint8_t id, const char **log)
+{
+    return bus.writeValue(id, 64, 1, 0) || fail(log);
+}
+
+bool DynamixelWorkbench::itemWrite(uint8_t id, const char *item_name, int32_t data, const char **log)
+{
+    const ControlItem *item = controlItem(item_name);
+    if (item == NULL)
+    {
+        return fail(log);
+    }
+    return bus.writeValue(id, item->address, item->data_length, (uint32_t)data) || fail(log);
+}
+
+bool DynamixelWorkbench::itemRead(uint8_t id, const char *item_name, int32_t *data, const char **log)
+{
+    const ControlItem *item = controlItem(item_name);
+    if (item == NULL || !bus.hasMotor(id))
+    {
+        return fail(log);
+    }
+    *data = (int32_t)bus.readValue(id, item->address, item->data_length);
+    return true;
+}
+
+int32_t DynamixelWorkbench::convertRadian2Value(uint8_t, float radian)
+{
+    const ModelInfo &m = modelInfo();
+    if (radian > 0)
+    {
+        return (radian * (m.value_of_max_radian_position - m.value_of_zero_radian_position) / m.max_radian) + m.value_of_zero_radian_position;
+    }
+    else if (radian < 0)
+    {
+        return (radian * (m.value_of_min_radian_position - m.value_of_zero_radian_position) / m.min_radian) + m.value_of_zero_radian_position;
+    }
+    return m.value_of_zero_radian_position;
+}
+
+float DynamixelWorkbench::convertValue2Radian(uint8_t, int32_t value)
+{
+    const ModelInfo &m = modelInfo();
+    if (value > m.value_of_zero_radian_position)
+    {
+        return (float)(value - m.value_of_zero_radian_position) * m.max_radian / (float)(m.value_of_max_radian_position - m.value_of_zero_radian_position);
+    }
+    else if (value < m.value_of_zero_radian_position)
+    {
+        return (float)(value - m.value_of_zero_radian_position) * m.min_radian / (float)(m.value_of_min_radian_position - m.value_of_zero_radian_position);
+    }
+    return 0.0f;
+}
+
+int32_t DynamixelWorkbench::convertVelocity2Value(uint8_t, float velocity)
+{
+    return (int32_t)(velocity * 60.0f / (2.0f * (float)M_PI) / modelInfo().rpm);
+}
+
+float DynamixelWorkbench::convertValue2Velocity(uint8_t, int32_t value)
+{
+    return (float)value * modelInfo().rpm * 2.0f * (float)M_PI / 60.0f;
+}
+
+float DynamixelWorkbench::convertValue2Current(uint8_t, int16_t value)
+{
+    return (float)value * DynamixelEmulator::CURRENT_UNIT;
+}
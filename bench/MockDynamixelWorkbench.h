@@ -0,0 +1,20 @@
+#pragma once
+
+#include "DynamixelEmulator.h"
+
+/**
+ * @brief Returns the emulated bus behind the mock DynamixelWorkbench.
+ *
+ * MockDynamixelWorkbench.cpp defines the DynamixelWorkbench / DynamixelDriver
+ * members used by DynamixelInterface, so that the interface runs against
+ * register memory instead of a serial port. Only the declarations of the
+ * dynamixel_workbench_toolbox headers are used: the toolbox library must not be
+ * linked into the same executable, and a member used by DynamixelInterface
+ * must be added here.
+ */
+DynamixelEmulator &mockDynamixelBus();
+
+/**
+ * @brief Removes the motors and the sync handlers of the mock bus.
+ */
+void resetMockDynamixelBus();
@@ -0,0 +1,383 @@
+#include "Protocol2Server.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    const uint8_t BROADCAST_ID = 0xFE;
+
+    const uint8_t INST_PING = 0x01;
+    const uint8_t INST_READ = 0x02;
+    const uint8_t INST_WRITE = 0x03;
+    const uint8_t INST_FACTORY_RESET = 0x06;
+    const uint8_t INST_REBOOT = 0x08;
+    const uint8_t INST_STATUS = 0x55;
+    const uint8_t INST_SYNC_READ = 0x82;
+    const uint8_t INST_SYNC_WRITE = 0x83;
+
+    const uint8_t ERR_INSTRUCTION = 0x02;
+    const uint8_t ERR_DATA_LENGTH = 0x05;
+    const uint8_t ERR_ACCESS = 0x07;
+
+    uint16_t updateCRC(uint16_t crc, const uint8_t *data, size_t size)
+    {
+        static uint16_t table[256];
+        static bool initialized = false;
+        if (!initialized)
+        {
+            // CRC-16 (polynomial 0x8005), as in the Protocol 2.0 specification
+            for (uint16_t i = 0; i < 256; i++)
+            {
+                uint16_t value = i << 8;
+                for (int b = 0; b < 8; b++)
+                {
+                    value = (value & 0x8000) ? (value << 1) ^ 0x8005 : (value << 1);
+                }
+                table[i] = value;
+            }
+            initialized = true;
+        }
+        for (size_t j = 0; j < size; j++)
+        {
+            uint8_t i = ((crc >> 8) ^ data[j]) & 0xFF;
+            crc = (crc << 8) ^ table[i];
+        }
+        return crc;
+    }
+
+    int64_t nowNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    void sleepUntilNs(int64_t deadline_ns)
+    {
+        struct timespec ts;
+        ts.tv_sec = deadline_ns / 1000000000LL;
+        ts.tv_nsec = deadline_ns % 1000000000LL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+        {
+        }
+    }
+
+    uint16_t word(const uint8_t *p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+}
+
+Protocol2Server::Protocol2Server(DynamixelEmulator &emulator)
+    : emulator_(emulator),
+      master_fd_(-1),
+      slave_fd_(-1),
+      baud_rate_(0)
+{
+}
+
+Protocol2Server::~Protocol2Server()
+{
+    close();
+}
+
+bool Protocol2Server::open(const std::string &link_path)
+{
+    master_fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master_fd_ < 0 || grantpt(master_fd_) != 0 || unlockpt(master_fd_) != 0)
+    {
+        std::cerr << "Failed to create a pseudo terminal: " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    port_name_ = ptsname(master_fd_);
+
+    // keep the slave open, so the master does not see a hang-up between host connections
+    slave_fd_ = ::open(port_name_.c_str(), O_RDWR | O_NOCTTY);
+    if (slave_fd_ < 0)
+    {
+        std::cerr << "Failed to open " << port_name_ << ": " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    struct termios tio;
+    tcgetattr(slave_fd_, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave_fd_, TCSANOW, &tio);
+
+    if (!link_path.empty())
+    {
+        unlink(link_path.c_str());
+        if (symlink(port_name_.c_str(), link_path.c_str()) != 0)
+        {
+            std::cerr << "Failed to link " << link_path << ": " << std::strerror(errno) << std::endl;
+            close();
+            return false;
+        }
+        link_path_ = link_path;
+    }
+    return true;
+}
+
+void Protocol2Server::close()
+{
+    if (!link_path_.empty())
+    {
+        unlink(link_path_.c_str());
+        link_path_.clear();
+    }
+    if (slave_fd_ >= 0)
+    {
+        ::close(slave_fd_);
+        slave_fd_ = -1;
+    }
+    if (master_fd_ >= 0)
+    {
+        ::close(master_fd_);
+        master_fd_ = -1;
+    }
+}
+
+const std::string &Protocol2Server::getPortName() const
+{
+    return port_name_;
+}
+
+void Protocol2Server::setBaudRate(uint32_t baud_rate)
+{
+    baud_rate_ = baud_rate;
+}
+
+void Protocol2Server::setWriteCallback(WriteCallback callback)
+{
+    write_callback_ = callback;
+}
+
+int64_t Protocol2Server::wireTime(size_t bytes) const
+{
+    // 1 start bit, 8 data bits, 1 stop bit
+    return (baud_rate_ > 0) ? (int64_t)bytes * 10 * 1000000000LL / baud_rate_ : 0;
+}
+
+uint8_t Protocol2Server::statusReturnLevel(uint8_t id) const
+{
+    return (uint8_t)emulator_.readValue(id, 68, 1);
+}
+
+int64_t Protocol2Server::returnDelay(uint8_t id) const
+{
+    // Return_Delay_Time is 2 [usec] per unit
+    return (int64_t)emulator_.readValue(id, 9, 1) * 2000;
+}
+
+bool Protocol2Server::poll(int timeout_ms)
+{
+    if (master_fd_ < 0)
+    {
+        return false;
+    }
+    struct pollfd pfd = {master_fd_, POLLIN, 0};
+    int ret = ::poll(&pfd, 1, timeout_ms);
+    if (ret <= 0)
+    {
+        return ret == 0;
+    }
+
+    uint8_t buf[4096];
+    ssize_t n = read(master_fd_, buf, sizeof(buf));
+    if (n <= 0)
+    {
+        return true;
+    }
+    // a pseudo terminal delivers at once, the wire time of the request is added per packet
+    int64_t received_ns = nowNs();
+    rx_.insert(rx_.end(), buf, buf + n);
+
+    while (true)
+    {
+        // header FF FF FD 00
+        size_t start = 0;
+        while (start + 4 <= rx_.size() &&
+               !(rx_[start] == 0xFF && rx_[start + 1] == 0xFF && rx_[start + 2] == 0xFD && rx_[start + 3] == 0x00))
+        {
+            start++;
+        }
+        rx_.erase(rx_.begin(), rx_.begin() + start);
+        if (rx_.size() < 7)
+        {
+            break;
+        }
+        size_t total = 7 + word(&rx_[5]);
+        if (rx_.size() < total)
+        {
+            break;
+        }
+
+        uint16_t crc = updateCRC(0, rx_.data(), total - 2);
+        if (crc == word(&rx_[total - 2]))
+        {
+            // remove byte stuffing (FF FF FD FD -> FF FF FD)
+            std::vector<uint8_t> packet(rx_.begin(), rx_.begin() + 7);
+            for (size_t i = 7; i < total - 2; i++)
+            {
+                packet.push_back(rx_[i]);
+                if (i + 1 < total - 2 && rx_[i + 1] == 0xFD && packet.size() >= 3 &&
+                    packet[packet.size() - 3] == 0xFF && packet[packet.size() - 2] == 0xFF && packet.back() == 0xFD)
+                {
+                    i++;
+                }
+            }
+            handlePacket(packet.data(), packet.size(), received_ns + wireTime(total));
+        }
+        rx_.erase(rx_.begin(), rx_.begin() + total);
+    }
+    return true;
+}
+
+void Protocol2Server::sendStatus(uint8_t id, uint8_t error, const uint8_t *params, size_t num_params, int64_t &deadline_ns)
+{
+    tx_.assign({0xFF, 0xFF, 0xFD, 0x00, id, 0, 0});
+    size_t payload = tx_.size();
+    tx_.push_back(INST_STATUS);
+    tx_.push_back(error);
+    tx_.insert(tx_.end(), params, params + num_params);
+    // byte stuffing
+    for (size_t i = payload; i + 2 < tx_.size(); i++)
+    {
+        if (tx_[i] == 0xFF && tx_[i + 1] == 0xFF && tx_[i + 2] == 0xFD)
+        {
+            tx_.insert(tx_.begin() + i + 3, 0xFD);
+            i += 2;
+        }
+    }
+    size_t length = tx_.size() - payload + 2;
+    tx_[5] = (uint8_t)length;
+    tx_[6] = (uint8_t)(length >> 8);
+    uint16_t crc = updateCRC(0, tx_.data(), tx_.size());
+    tx_.push_back((uint8_t)crc);
+    tx_.push_back((uint8_t)(crc >> 8));
+
+    // the status is complete on the wire after the return delay and its own wire time
+    deadline_ns += returnDelay(id) + wireTime(tx_.size());
+    sleepUntilNs(deadline_ns);
+    size_t written = 0;
+    while (written < tx_.size())
+    {
+        ssize_t n = write(master_fd_, tx_.data() + written, tx_.size() - written);
+        if (n <= 0)
+        {
+            break;
+        }
+        written += n;
+    }
+}
+
+void Protocol2Server::handlePacket(const uint8_t *packet, size_t length, int64_t received_ns)
+{
+    // received_ns is the time the last byte of the request is on the wire
+    uint8_t id = packet[4];
+    uint8_t instruction = packet[7];
+    const uint8_t *params = packet + 8;
+    size_t num_params = length - 8;
+    int64_t deadline_ns = received_ns;
+    uint8_t data[1024];
+
+    switch (instruction)
+    {
+    case INST_PING:
+        for (int target = 0; target < 253; target++)
+        {
+            if ((id == BROADCAST_ID || id == target) && emulator_.hasMotor(target))
+            {
+                uint8_t info[3] = {(uint8_t)DynamixelEmulator::MODEL_NUMBER, (uint8_t)(DynamixelEmulator::MODEL_NUMBER >> 8),
+                                   (uint8_t)emulator_.readValue(target, 6, 1)};
+                sendStatus(target, 0, info, sizeof(info), deadline_ns);
+            }
+        }
+        break;
+
+    case INST_READ:
+        if (emulator_.hasMotor(id) && statusReturnLevel(id) >= 1)
+        {
+            uint16_t address = (num_params >= 4) ? word(params) : 0;
+            uint16_t size = (num_params >= 4) ? word(params + 2) : 0;
+            bool ok = num_params >= 4 && size <= sizeof(data) && emulator_.read(id, address, size, data);
+            sendStatus(id, ok ? 0 : ERR_DATA_LENGTH, data, ok ? size : 0, deadline_ns);
+        }
+        break;
+
+    case INST_WRITE:
+        if (emulator_.hasMotor(id) && num_params >= 2)
+        {
+            uint16_t address = word(params);
+            uint16_t size = num_params - 2;
+            bool ok = emulator_.write(id, address, size, params + 2);
+            if (ok && write_callback_)
+            {
+                write_callback_(id, address, size);
+            }
+            if (statusReturnLevel(id) >= 2)
+            {
+                sendStatus(id, ok ? 0 : ERR_ACCESS, NULL, 0, deadline_ns);
+            }
+        }
+        break;
+
+    case INST_SYNC_READ:
+        if (num_params >= 4)
+        {
+            uint16_t address = word(params);
+            uint16_t size = word(params + 2);
+            for (size_t i = 4; i < num_params; i++)
+            {
+                uint8_t target = params[i];
+                if (emulator_.hasMotor(target) && size <= sizeof(data) && emulator_.read(target, address, size, data))
+                {
+                    sendStatus(target, 0, data, size, deadline_ns);
+                }
+            }
+        }
+        break;
+
+    case INST_SYNC_WRITE:
+        if (num_params >= 4)
+        {
+            uint16_t address = word(params);
+            uint16_t size = word(params + 2);
+            for (size_t i = 4; i + 1 + size <= num_params; i += 1 + size)
+            {
+                uint8_t target = params[i];
+                if (emulator_.write(target, address, size, params + i + 1) && write_callback_)
+                {
+                    write_callback_(target, address, size);
+                }
+            }
+        }
+        break;
+
+    case INST_REBOOT:
+    case INST_FACTORY_RESET:
+        if (emulator_.hasMotor(id))
+        {
+            sendStatus(id, 0, NULL, 0, deadline_ns);
+        }
+        break;
+
+    default:
+        if (emulator_.hasMotor(id))
+        {
+            sendStatus(id, ERR_INSTRUCTION, NULL, 0, deadline_ns);
+        }
+        break;
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "DynamixelEmulator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Serves Dynamixel Protocol 2.0 packets for a DynamixelEmulator on a pseudo terminal.
+ *
+ * Supports PING (including broadcast), READ, WRITE, SYNC READ, SYNC WRITE,
+ * REBOOT and FACTORY RESET, byte stuffing and CRC, and Status_Return_Level.
+ * Status packets are delayed by the wire time at the emulated baud rate plus
+ * Return_Delay_Time, so the host sees the timing of a real bus.
+ */
+class Protocol2Server
+{
+public:
+    /**
+     * @brief Called after a WRITE or SYNC WRITE has been applied to a motor.
+     */
+    using WriteCallback = std::function<void(uint8_t id, uint16_t address, uint16_t length)>;
+
+    /**
+     * @brief Constructor for the server class.
+     *
+     * @param emulator Emulated motors
+     */
+    explicit Protocol2Server(DynamixelEmulator &emulator);
+
+    /**
+     * @brief Destructor for the server class.
+     */
+    ~Protocol2Server();
+
+    /**
+     * @brief Creates the pseudo terminal.
+     *
+     * @param link_path Optional symbolic link to the slave device (e.g. "/tmp/ttyDXL")
+     * @return true Successful
+     * @return false Failed to create the pseudo terminal
+     */
+    bool open(const std::string &link_path = "");
+
+    /**
+     * @brief Closes the pseudo terminal and removes the link.
+     */
+    void close();
+
+    /**
+     * @brief Returns the device to be given as port_name.
+     */
+    const std::string &getPortName() const;
+
+    /**
+     * @brief Sets the baud rate of the wire time model (0: no delay).
+     */
+    void setBaudRate(uint32_t baud_rate);
+
+    /**
+     * @brief Sets the callback for writes.
+     */
+    void setWriteCallback(WriteCallback callback);
+
+    /**
+     * @brief Processes the received packets.
+     *
+     * @param timeout_ms Maximum time to wait for data [msec]
+     * @return true Successful
+     * @return false The pseudo terminal is closed
+     */
+    bool poll(int timeout_ms);
+
+    /**
+     * @brief Returns the wire time of a packet [nsec].
+     */
+    int64_t wireTime(size_t bytes) const;
+
+private:
+    void handlePacket(const uint8_t *packet, size_t length, int64_t received_ns);
+    void sendStatus(uint8_t id, uint8_t error, const uint8_t *params, size_t num_params, int64_t &deadline_ns);
+    uint8_t statusReturnLevel(uint8_t id) const;
+    int64_t returnDelay(uint8_t id) const;
+
+    DynamixelEmulator &emulator_;
+    int master_fd_;
+    int slave_fd_;
+    std::string port_name_;
+    std::string link_path_;
+    uint32_t baud_rate_;
+    WriteCallback write_callback_;
+    std::vector<uint8_t> rx_;
+    std::vector<uint8_t> tx_;
+};
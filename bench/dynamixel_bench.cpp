@@ -0,0 +1,176 @@
+#include <benchmark/benchmark.h>
+
+#include <iostream>
+#include <sstream>
+
+#include "DynamixelInterface.h"
+#include "MockDynamixelWorkbench.h"
+
+/*
+  Microbenchmarks of the DynamixelInterface hot path against the mock bus
+  (MockDynamixelWorkbench.cpp), so the serial time is excluded.
+  Arguments: number of joints, number of communication groups.
+
+  ./dynamixel_bench --benchmark_format=json --benchmark_out=result.json
+*/
+
+namespace
+{
+    /**
+     * @brief DynamixelInterface initialized on the mock bus.
+     */
+    struct MockSetup
+    {
+        DynamixelInterface di;
+        size_t num_joints;
+        std::vector<int32_t> raw;
+        std::vector<irsl_shm_controller::irsl_float_type> value;
+
+        MockSetup(size_t joints, size_t groups, bool indirect = true, int refresh_cycles = -1)
+            : num_joints(joints), raw(joints), value(joints)
+        {
+            resetMockDynamixelBus();
+
+            YAML::Node settings;
+            settings["port_name"] = "/dev/null";
+            settings["baud_rate"] = 4000000;
+            settings["period"] = 0.001;
+            settings["indirect_address"] = indirect;
+            if (refresh_cycles >= 0)
+            {
+                settings["command_refresh_cycles"] = refresh_cycles;
+            }
+            for (size_t i = 0; i < joints; i++)
+            {
+                // IDs 0..252 are valid
+                uint8_t id = (uint8_t)i;
+                mockDynamixelBus().addMotor(id);
+
+                YAML::Node joint;
+                joint["ID"] = (int)id;
+                joint["CommunicationGroupName"] = "group" + std::to_string(i % groups);
+                settings["joint"].push_back(joint);
+            }
+
+            // keep the initialization messages out of the benchmark output
+            std::ostringstream discard;
+            std::streambuf *cout_buf = std::cout.rdbuf(discard.rdbuf());
+            di.setCommandItems({"Goal_Position"});
+            bool result = di.initialize(settings);
+            std::cout.rdbuf(cout_buf);
+            if (!result)
+            {
+                throw std::runtime_error("failed to initialize DynamixelInterface on the mock bus");
+            }
+
+            for (size_t i = 0; i < joints; i++)
+            {
+                raw[i] = DynamixelEmulator::POSITION_CENTER + (int32_t)(i * 7);
+                value[i] = 0.001 * i - 0.1;
+            }
+        }
+    };
+
+    void jointsAndGroups(benchmark::internal::Benchmark *b)
+    {
+        for (int joints : {5, 32, 128, 253})
+        {
+            for (int groups : {1, 2, 4, 8})
+            {
+                b->Args({joints, groups});
+            }
+        }
+    }
+
+    void joints(benchmark::internal::Benchmark *b)
+    {
+        for (int joints : {5, 32, 128, 253})
+        {
+            b->Args({joints, 1});
+        }
+    }
+}
+
+static void BM_ConvertPosition(benchmark::State &state)
+{
+    MockSetup setup(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        setup.di.convertPosition(setup.raw, setup.value);
+        benchmark::DoNotOptimize(setup.value.data());
+    }
+    state.SetItemsProcessed(state.iterations() * setup.num_joints);
+}
+BENCHMARK(BM_ConvertPosition)->Apply(joints);
+
+static void BM_ConvertPositionCmd(benchmark::State &state)
+{
+    MockSetup setup(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        setup.di.convertPositionCmd(setup.value, setup.raw);
+        benchmark::DoNotOptimize(setup.raw.data());
+    }
+    state.SetItemsProcessed(state.iterations() * setup.num_joints);
+}
+BENCHMARK(BM_ConvertPositionCmd)->Apply(joints);
+
+static void BM_GetCurrentStatus(benchmark::State &state)
+{
+    MockSetup setup(state.range(0), state.range(1));
+    std::vector<int32_t> pos(setup.num_joints), vel(setup.num_joints), cur(setup.num_joints);
+    for (auto _ : state)
+    {
+        setup.di.getDynamixelCurrentStatus(pos, vel, cur);
+        benchmark::DoNotOptimize(pos.data());
+    }
+    state.SetItemsProcessed(state.iterations() * setup.num_joints);
+}
+BENCHMARK(BM_GetCurrentStatus)->Apply(jointsAndGroups);
+
+static void BM_GetCurrentStatusDirect(benchmark::State &state)
+{
+    MockSetup setup(state.range(0), state.range(1), false);
+    std::vector<int32_t> pos(setup.num_joints), vel(setup.num_joints), cur(setup.num_joints);
+    for (auto _ : state)
+    {
+        setup.di.getDynamixelCurrentStatus(pos, vel, cur);
+        benchmark::DoNotOptimize(pos.data());
+    }
+    state.SetItemsProcessed(state.iterations() * setup.num_joints);
+}
+BENCHMARK(BM_GetCurrentStatusDirect)->Apply(jointsAndGroups);
+
+// writeBySyncHandler: every goal changes, so each group is packed and sent
+static void BM_WriteGoals(benchmark::State &state)
+{
+    MockSetup setup(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        for (auto &v : setup.raw)
+        {
+            v ^= 1;
+        }
+        setup.di.setGoal("Goal_Position", setup.raw);
+        setup.di.writeGoals();
+    }
+    state.SetItemsProcessed(state.iterations() * setup.num_joints);
+}
+BENCHMARK(BM_WriteGoals)->Apply(jointsAndGroups);
+
+// writeBySyncHandler: nothing changed and the refresh is disabled, so every packet is skipped
+static void BM_WriteGoalsUnchanged(benchmark::State &state)
+{
+    MockSetup setup(state.range(0), state.range(1), true, 0);
+    setup.di.setGoal("Goal_Position", setup.raw);
+    setup.di.writeGoals();
+    for (auto _ : state)
+    {
+        setup.di.setGoal("Goal_Position", setup.raw);
+        setup.di.writeGoals();
+    }
+    state.SetItemsProcessed(state.iterations() * setup.num_joints);
+}
+BENCHMARK(BM_WriteGoalsUnchanged)->Apply(jointsAndGroups);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,64 @@
+#include <signal.h>
+#include <time.h>
+
+#include <atomic>
+#include <iostream>
+
+#include "CLI11.hpp"
+
+#include "DynamixelEmulator.h"
+#include "Protocol2Server.h"
+
+static std::atomic<bool> running(true);
+
+static void on_signal(int)
+{
+    running = false;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<int> ids = {1};
+    uint32_t baud_rate = 1000000;
+    std::string link_path = "/tmp/ttyDXL";
+    bool instant = false;
+
+    CLI::App vm{"Dynamixel Protocol 2.0 emulator on a pseudo terminal"};
+    vm.add_option("--id", ids, "IDs of the emulated motors")->default_val("1");
+    vm.add_option("--baud_rate", baud_rate, "Baud rate of the wire time model (0: no delay)")->default_val("1000000");
+    vm.add_option("--link", link_path, "Symbolic link to the pseudo terminal")->default_val("/tmp/ttyDXL");
+    vm.add_flag("--instant", instant, "Position controlled motors reach the goal at once");
+    CLI11_PARSE(vm, argc, argv);
+
+    DynamixelEmulator emulator;
+    for (int id : ids)
+    {
+        emulator.addMotor((uint8_t)id);
+    }
+    emulator.setInstantMotion(instant);
+
+    Protocol2Server server(emulator);
+    if (!server.open(link_path))
+    {
+        return -1;
+    }
+    server.setBaudRate(baud_rate);
+    std::cout << "port_name: " << link_path << " (" << server.getPortName() << ")" << std::endl;
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    struct timespec last;
+    clock_gettime(CLOCK_MONOTONIC, &last);
+    while (running)
+    {
+        server.poll(1);
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        emulator.step((now.tv_sec - last.tv_sec) + (now.tv_nsec - last.tv_nsec) * 1e-9);
+        last = now;
+    }
+
+    return 0;
+}
@@ -0,0 +1,494 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "irsl/shm_controller.h"
+
+#include "CLI11.hpp"
+
+#include "DynamixelEmulator.h"
+#include "Protocol2Server.h"
+
+using namespace irsl_shm_controller;
+
+/*
+  End-to-end latency of robot_hardware against the pty emulator (Protocol2Server.cpp).
+
+  For each sample, a command of joint 0 is written to the shered memory (t0).
+  The emulator detects the goal in its Goal_Position (or Goal_Current) register (t1), the motor
+  reaches it at once, and the client polls readPositionCurrent (or readTorqueCurrent) until the
+  new value appears (t2).
+    command_to_bus      : t1 - t0
+    command_to_feedback : t2 - t0
+
+  ./latency_bench --robot_hardware ./robot_hardware --periods 0.001 0.002 --bauds 1000000 4000000 --groups 1 2
+  ./latency_bench --robot_hardware ./robot_hardware --periods 0.001 --joint_type TorqueCommand
+*/
+
+namespace
+{
+    /**
+     * @brief Goal register and command of a --joint_type.
+     */
+    struct CommandSpec
+    {
+        const char *joint_type;
+        uint16_t goal_address;
+        uint16_t goal_length;
+        double step;      ///< Command of joint 0 alternates between +/- step
+        double tolerance; ///< Feedback tolerance
+    };
+
+    // position [rad], and current [mA] (TorqueConstant 1.0, i.e. torque in the current unit of the model)
+    const CommandSpec POSITION_COMMAND = {"PositionCommand", 116, 4, 0.1, 0.01};
+    const CommandSpec TORQUE_COMMAND = {"TorqueCommand", 102, 2, 100.0, DynamixelEmulator::CURRENT_UNIT};
+    const int64_t SAMPLE_TIMEOUT_NS = 1000000000;
+    const int64_t STARTUP_TIMEOUT_NS = 20000000000;
+
+    int64_t monotonicNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    void sleepNs(int64_t ns)
+    {
+        struct timespec ts;
+        ts.tv_sec = ns / 1000000000;
+        ts.tv_nsec = ns % 1000000000;
+        nanosleep(&ts, nullptr);
+    }
+
+    /**
+     * @brief Raw Goal_Position of the emulated model (XM430) for the given angle.
+     */
+    int32_t radianToRaw(double radian)
+    {
+        const double center = DynamixelEmulator::POSITION_CENTER;
+        return (int32_t)(radian * (DynamixelEmulator::POSITION_RANGE - 1 - center) / M_PI + center);
+    }
+
+    /**
+     * @brief Raw goal of the emulated model for the given command.
+     */
+    int32_t commandToRaw(const CommandSpec &spec, double command)
+    {
+        if (spec.goal_address == TORQUE_COMMAND.goal_address)
+        {
+            return (int32_t)std::lround(command / DynamixelEmulator::CURRENT_UNIT);
+        }
+        return radianToRaw(command);
+    }
+
+    struct Condition
+    {
+        const CommandSpec *spec;
+        double period;
+        uint32_t baud_rate;
+        size_t joints;
+        size_t groups;
+    };
+
+    /**
+     * @brief Emulated bus served from a background thread.
+     */
+    class EmulatedBus
+    {
+    public:
+        EmulatedBus(const CommandSpec &spec, size_t joints, uint32_t baud_rate)
+            : spec_(spec),
+              server_(emulator_),
+              running_(false),
+              expected_raw_(0),
+              command_ns_(0),
+              bus_ns_(0)
+        {
+            for (size_t i = 0; i < joints; i++)
+            {
+                emulator_.addMotor((uint8_t)i);
+            }
+            emulator_.setInstantMotion(true);
+            server_.setBaudRate(baud_rate);
+            server_.setWriteCallback([this](uint8_t id, uint16_t, uint16_t) { onWrite(id); });
+        }
+
+        ~EmulatedBus()
+        {
+            stop();
+        }
+
+        bool start()
+        {
+            if (!server_.open())
+            {
+                return false;
+            }
+            running_ = true;
+            thread_ = std::thread([this]() { run(); });
+            return true;
+        }
+
+        void stop()
+        {
+            if (running_)
+            {
+                running_ = false;
+                thread_.join();
+            }
+            server_.close();
+        }
+
+        const std::string &getPortName() const
+        {
+            return server_.getPortName();
+        }
+
+        /**
+         * @brief Arms the detection of the next goal of joint 0.
+         */
+        void expect(int32_t raw, int64_t command_ns)
+        {
+            bus_ns_.store(0, std::memory_order_relaxed);
+            expected_raw_.store(raw, std::memory_order_relaxed);
+            command_ns_.store(command_ns, std::memory_order_release);
+        }
+
+        /**
+         * @brief Returns the time the expected goal reached the emulator (0: not yet).
+         */
+        int64_t getBusTime() const
+        {
+            return bus_ns_.load(std::memory_order_acquire);
+        }
+
+    private:
+        void run()
+        {
+            int64_t last = monotonicNs();
+            while (running_)
+            {
+                server_.poll(1);
+                int64_t now = monotonicNs();
+                emulator_.step((now - last) * 1e-9);
+                last = now;
+            }
+        }
+
+        // called from the server thread after a write was applied
+        void onWrite(uint8_t id)
+        {
+            if (id != 0 || command_ns_.load(std::memory_order_acquire) == 0 || bus_ns_.load(std::memory_order_relaxed) != 0)
+            {
+                return;
+            }
+            uint32_t value = emulator_.readValue(0, spec_.goal_address, spec_.goal_length);
+            int32_t goal = (spec_.goal_length == 2) ? (int16_t)value : (int32_t)value;
+            if (std::abs(goal - expected_raw_.load(std::memory_order_relaxed)) <= 1)
+            {
+                bus_ns_.store(monotonicNs(), std::memory_order_release);
+            }
+        }
+
+        const CommandSpec &spec_;
+        DynamixelEmulator emulator_;
+        Protocol2Server server_;
+        std::thread thread_;
+        std::atomic<bool> running_;
+        std::atomic<int32_t> expected_raw_;
+        std::atomic<int64_t> command_ns_;
+        std::atomic<int64_t> bus_ns_;
+    };
+
+    bool writeConfig(const std::string &path, const Condition &c, const std::string &port_name)
+    {
+        std::ofstream ofs(path);
+        if (!ofs)
+        {
+            std::cerr << "Failed to write " << path << std::endl;
+            return false;
+        }
+        ofs << "dynamixel_hardware_shm:\n";
+        ofs << "  period: " << c.period << "\n";
+        ofs << "  port_name: " << port_name << "\n";
+        ofs << "  baud_rate: " << c.baud_rate << "\n";
+        ofs << "  joint:\n";
+        for (size_t i = 0; i < c.joints; i++)
+        {
+            ofs << "    - { ID: " << i << ", CommunicationGroupName: group" << (i % c.groups);
+            if (c.spec == &TORQUE_COMMAND)
+            {
+                // current control
+                ofs << ", DynamixelSettings: { Operating_Mode: 0 }";
+            }
+            ofs << " }\n";
+        }
+        return true;
+    }
+
+    pid_t spawn(const std::string &robot_hardware, const std::string &hash, const std::string &key,
+                const std::string &config, const char *joint_type, bool verbose)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            if (!verbose)
+            {
+                int null_fd = ::open("/dev/null", O_WRONLY);
+                dup2(null_fd, STDOUT_FILENO);
+            }
+            execl(robot_hardware.c_str(), robot_hardware.c_str(), hash.c_str(), key.c_str(), config.c_str(),
+                  "--joint_type", joint_type, (char *)nullptr);
+            _exit(127);
+        }
+        return pid;
+    }
+
+    void stopProcess(pid_t pid)
+    {
+        kill(pid, SIGTERM);
+        int status;
+        waitpid(pid, &status, 0);
+    }
+
+    /**
+     * @brief Waits until robot_hardware has created the shered memory and its loop is running.
+     */
+    bool waitForLoop(ShmManager &sm, pid_t pid)
+    {
+        int64_t deadline = monotonicNs() + STARTUP_TIMEOUT_NS;
+        while (monotonicNs() < deadline)
+        {
+            int status;
+            if (waitpid(pid, &status, WNOHANG) == pid)
+            {
+                std::cerr << "robot_hardware exited during initialization" << std::endl;
+                return false;
+            }
+            if (sm.openSharedMemory(false) && sm.checkHeader())
+            {
+                uint64_t frame = sm.getFrame();
+                sleepNs(100000000);
+                if (sm.getFrame() > frame)
+                {
+                    return true;
+                }
+            }
+            else
+            {
+                sleepNs(100000000);
+            }
+        }
+        std::cerr << "robot_hardware did not start" << std::endl;
+        return false;
+    }
+
+    double percentile(const std::vector<int64_t> &sorted, double p)
+    {
+        size_t index = (size_t)std::lround(p * (sorted.size() - 1));
+        return sorted[index] * 1e-3;
+    }
+
+    void report(const Condition &c, const char *metric, std::vector<int64_t> &samples)
+    {
+        std::cout << c.spec->joint_type << "," << c.period << "," << c.baud_rate << "," << c.joints << "," << c.groups << "," << metric << "," << samples.size();
+        if (samples.empty())
+        {
+            std::cout << ",,,,," << std::endl;
+            return;
+        }
+        std::sort(samples.begin(), samples.end());
+        std::cout << "," << samples.front() * 1e-3
+                  << "," << percentile(samples, 0.5)
+                  << "," << percentile(samples, 0.9)
+                  << "," << percentile(samples, 0.99)
+                  << "," << samples.back() * 1e-3 << std::endl;
+    }
+
+    bool measure(const Condition &c, const std::string &robot_hardware, int32_t hash, int32_t key,
+                 size_t num_samples, bool verbose)
+    {
+        EmulatedBus bus(*c.spec, c.joints, c.baud_rate);
+        if (!bus.start())
+        {
+            return false;
+        }
+
+        std::string config = "/tmp/latency_bench_" + std::to_string(getpid()) + ".yaml";
+        if (!writeConfig(config, c, bus.getPortName()))
+        {
+            return false;
+        }
+        pid_t pid = spawn(robot_hardware, std::to_string(hash), std::to_string(key), config, c.spec->joint_type, verbose);
+        if (pid < 0)
+        {
+            std::cerr << "Failed to start " << robot_hardware << std::endl;
+            unlink(config.c_str());
+            return false;
+        }
+
+        ShmSettings ss;
+        ss.hash = hash;
+        ss.shm_key = key;
+        ss.numJoints = c.joints;
+        ss.numForceSensors = 0;
+        ss.numImuSensors = 0;
+        bool torque = (c.spec == &TORQUE_COMMAND);
+        ss.jointType = torque ? ShmSettings::JointType::TorqueCommand : ShmSettings::JointType::PositionCommand;
+        ShmManager sm(ss);
+
+        bool result = waitForLoop(sm, pid);
+        unlink(config.c_str());
+        if (!result)
+        {
+            stopProcess(pid);
+            return false;
+        }
+
+        std::vector<irsl_float_type> command(c.joints);
+        std::vector<irsl_float_type> feedback(c.joints);
+        if (torque)
+        {
+            sm.readTorqueCommand(command);
+        }
+        else
+        {
+            sm.readPositionCommand(command);
+        }
+
+        std::vector<int64_t> to_bus;
+        std::vector<int64_t> to_feedback;
+        to_bus.reserve(num_samples);
+        to_feedback.reserve(num_samples);
+        size_t timeouts = 0;
+        const int64_t period_ns = (int64_t)(c.period * 1e9);
+        for (size_t n = 0; n < num_samples; n++)
+        {
+            const double target = (n % 2 == 0) ? c.spec->step : -c.spec->step;
+            command[0] = target;
+
+            int64_t t0 = monotonicNs();
+            bus.expect(commandToRaw(*c.spec, target), t0);
+            if (torque)
+            {
+                sm.writeTorqueCommand(command);
+            }
+            else
+            {
+                sm.writePositionCommand(command);
+            }
+
+            int64_t t2 = 0;
+            while (monotonicNs() - t0 < SAMPLE_TIMEOUT_NS)
+            {
+                bool read = torque ? sm.readTorqueCurrent(feedback) : sm.readPositionCurrent(feedback);
+                if (read && std::fabs(feedback[0] - target) < c.spec->tolerance)
+                {
+                    t2 = monotonicNs();
+                    break;
+                }
+            }
+            int64_t t1 = bus.getBusTime();
+            if (t1 != 0)
+            {
+                to_bus.push_back(t1 - t0);
+            }
+            if (t2 != 0)
+            {
+                to_feedback.push_back(t2 - t0);
+            }
+            else
+            {
+                timeouts++;
+            }
+
+            // spread the command over the phase of the control cycle
+            sleepNs(period_ns + (int64_t)(n * 7919) % period_ns);
+        }
+
+        stopProcess(pid);
+        bus.stop();
+
+        if (timeouts > 0)
+        {
+            std::cerr << timeouts << " samples timed out (period: " << c.period << ", baud_rate: " << c.baud_rate
+                      << ", groups: " << c.groups << ")" << std::endl;
+        }
+        report(c, "command_to_bus", to_bus);
+        report(c, "command_to_feedback", to_feedback);
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string robot_hardware = "./robot_hardware";
+    std::vector<double> periods = {0.002};
+    std::vector<uint32_t> bauds = {1000000};
+    std::vector<size_t> joints = {5};
+    std::vector<size_t> groups = {1};
+    size_t num_samples = 200;
+    int32_t hash = 8888;
+    int32_t key = 9100;
+    std::string joint_type = "PositionCommand";
+    bool verbose = false;
+
+    CLI::App vm{"Command-to-feedback latency of robot_hardware against the emulated bus"};
+    vm.add_option("--robot_hardware", robot_hardware, "Path to robot_hardware")->default_val("./robot_hardware");
+    vm.add_option("--periods", periods, "Control periods [sec]")->default_val("0.002");
+    vm.add_option("--bauds", bauds, "Baud rates")->default_val("1000000");
+    vm.add_option("--joints", joints, "Numbers of joints")->default_val("5");
+    vm.add_option("--groups", groups, "Numbers of communication groups")->default_val("1");
+    vm.add_option("--samples", num_samples, "Samples for each condition")->default_val("200");
+    vm.add_option("--shm_hash", hash, "sherad memory hash")->default_val("8888");
+    vm.add_option("--shm_key", key, "sherad memory key of the first condition")->default_val("9100");
+    vm.add_option("--joint_type", joint_type, "Commanded joint type (PositionCommand, TorqueCommand)")->default_val("PositionCommand");
+    vm.add_flag("-v,--verbose", verbose, "Show the output of robot_hardware");
+    CLI11_PARSE(vm, argc, argv);
+
+    const CommandSpec *spec = nullptr;
+    for (const CommandSpec *candidate : {&POSITION_COMMAND, &TORQUE_COMMAND})
+    {
+        if (joint_type == candidate->joint_type)
+        {
+            spec = candidate;
+        }
+    }
+    if (spec == nullptr)
+    {
+        std::cerr << "unknown joint type [" << joint_type << "]" << std::endl;
+        return -1;
+    }
+
+    std::cout << "joint_type,period,baud_rate,joints,groups,metric,samples,min_us,p50_us,p90_us,p99_us,max_us" << std::endl;
+
+    int result = 0;
+    for (double period : periods)
+    {
+        for (uint32_t baud_rate : bauds)
+        {
+            for (size_t joint_num : joints)
+            {
+                for (size_t group_num : groups)
+                {
+                    Condition c = {spec, period, baud_rate, joint_num, std::max<size_t>(1, std::min(group_num, joint_num))};
+                    // a fresh shered memory for each condition, so a stale header is never accepted
+                    if (!measure(c, robot_hardware, hash, key++, num_samples, verbose))
+                    {
+                        result = -1;
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A kind of transaction issued on the bus every cycle.
+ */
+struct BusTransaction
+{
+    std::string name;      ///< Description (e.g. "sync read [group0]")
+    double per_cycle;      ///< Average number of transactions per cycle
+    size_t request_bytes;  ///< Instruction packet size [byte]
+    size_t response_bytes; ///< Total size of the status packets [byte]
+    double return_delay;   ///< Total Return_Delay_Time of the responding Dynamixels [sec]
+    double time;           ///< Predicted time of one transaction [sec]
+};
+
+/**
+ * @brief Predicts the bus time of a control cycle.
+ *
+ * Packet sizes follow Dynamixel Protocol 1.0 / 2.0 (without byte stuffing),
+ * each byte takes 10 bits on the wire (8N1), and every status packet is
+ * preceded by the Return_Delay_Time of the responding Dynamixel (2 [usec] per unit).
+ * Sync writes are never answered. Protocol 1.0 has no sync read, so it is
+ * predicted as one read per Dynamixel.
+ */
+class BusPlanner
+{
+public:
+    /**
+     * @brief Constructor for the planner class.
+     */
+    BusPlanner();
+
+    /**
+     * @brief Sets the bus and removes the transactions.
+     *
+     * @param baud_rate Baud rate of the bus
+     * @param protocol_version Protocol version (1.0 or 2.0)
+     */
+    void setBus(int32_t baud_rate, float protocol_version);
+
+    /**
+     * @brief Sets the host side time added to each transaction (e.g. USB latency).
+     *
+     * @param overhead Time per transaction [sec]
+     */
+    void setTransactionOverhead(double overhead);
+
+    /**
+     * @brief Adds a sync read issued every cycle.
+     *
+     * @param name Description of the transaction
+     * @param return_delay_times Return_Delay_Time of each Dynamixel read (raw value)
+     * @param data_length Length of the read window [byte]
+     */
+    void addSyncRead(const std::string &name, const std::vector<int32_t> &return_delay_times, uint16_t data_length);
+
+    /**
+     * @brief Adds a sync write issued every cycle.
+     *
+     * @param name Description of the transaction
+     * @param num_ids Number of Dynamixels written
+     * @param data_length Length of the data for each Dynamixel [byte]
+     */
+    void addSyncWrite(const std::string &name, size_t num_ids, uint16_t data_length);
+
+    /**
+     * @brief Adds a read of a single Dynamixel.
+     *
+     * @param name Description of the transaction
+     * @param return_delay_time Return_Delay_Time of the Dynamixel (raw value)
+     * @param data_length Length of the data [byte]
+     * @param per_cycle Average number of reads per cycle
+     */
+    void addRead(const std::string &name, int32_t return_delay_time, uint16_t data_length, double per_cycle);
+
+    /**
+     * @brief Returns the predicted transactions.
+     */
+    const std::vector<BusTransaction> &getTransactions() const;
+
+    /**
+     * @brief Returns the predicted bus time of a cycle [sec].
+     */
+    double getCycleTime() const;
+
+    /**
+     * @brief Returns the maximum feasible cycle rate [Hz].
+     */
+    double getMaxRate() const;
+
+    /**
+     * @brief Returns the bus utilization at the given period.
+     *
+     * @param period Control period [sec]
+     * @return double Cycle time / period (above 1.0 the period can not be met)
+     */
+    double getUtilization(double period) const;
+
+    /**
+     * @brief Prints the transactions, the cycle time and the utilization.
+     *
+     * @param os Output stream
+     * @param period Control period [sec]
+     */
+    void print(std::ostream &os, double period) const;
+
+    /**
+     * @brief Returns the wire time of the given number of bytes [sec].
+     */
+    double wireTime(size_t bytes) const;
+
+private:
+    size_t instructionSize(size_t num_params) const;
+    size_t statusSize(size_t num_params) const;
+    void addTransaction(const std::string &name, double per_cycle, size_t request_bytes, size_t response_bytes, double return_delay);
+
+    int32_t baud_rate_;
+    float protocol_version_;
+    double overhead_;
+    std::vector<BusTransaction> transactions_;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "irsl/shm_controller.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Interpolates commands between controller updates and bus cycles.
+ *
+ * The controller updates the command every command_period, while the
+ * hardware loop runs every control period. A new command is detected when
+ * its value changes, and the output moves from the current output to the
+ * new command over one command_period.
+ */
+class CommandInterpolator
+{
+public:
+    /**
+     * @brief Interpolation method.
+     */
+    enum class Method
+    {
+        Hold,   ///< Output the latest command as is
+        Linear, ///< Linear interpolation to the latest command
+        Cubic   ///< Cubic Hermite interpolation (continuous velocity)
+    };
+
+    /**
+     * @brief Constructor for the interpolator class.
+     */
+    CommandInterpolator();
+
+    /**
+     * @brief Parses the name of an interpolation method.
+     *
+     * @param name "hold", "linear" or "cubic"
+     * @param method Output: Interpolation method
+     * @return true Successful
+     * @return false Unknown name
+     */
+    static bool parseMethod(const std::string &name, Method &method);
+
+    /**
+     * @brief Allocates the buffers and sets the interpolation parameters.
+     *
+     * @param num_joints Number of joints
+     * @param method Interpolation method
+     * @param command_period Update period of the controller [sec]
+     * @param control_period Period of the hardware loop [sec]
+     */
+    void initialize(size_t num_joints, Method method, double command_period, double control_period);
+
+    /**
+     * @brief Resets the output and the latest command to the given value.
+     *
+     * @param cmd_vec Input: Initial command (e.g. current position)
+     */
+    void reset(const std::vector<irsl_shm_controller::irsl_float_type> &cmd_vec);
+
+    /**
+     * @brief Advances one control cycle.
+     *
+     * Does not allocate once initialized.
+     *
+     * @param cmd_vec Input: Command read from shared memory
+     * @param out_vec Output: Interpolated command
+     */
+    void update(
+        const std::vector<irsl_shm_controller::irsl_float_type> &cmd_vec,
+        std::vector<irsl_shm_controller::irsl_float_type> &out_vec);
+
+private:
+    Method method_;
+    double cycles_per_command_; ///< Number of control cycles in a command period
+    double step_;               ///< Increment of the interpolation parameter per cycle
+    double s_;                  ///< Interpolation parameter in [0, 1]
+
+    std::vector<irsl_shm_controller::irsl_float_type> latest_;     ///< Latest command
+    std::vector<irsl_shm_controller::irsl_float_type> start_;      ///< Output when the latest command arrived
+    std::vector<irsl_shm_controller::irsl_float_type> start_vel_;  ///< Output velocity when the latest command arrived [per command period]
+    std::vector<irsl_shm_controller::irsl_float_type> target_vel_; ///< Velocity at the latest command [per command period]
+    std::vector<irsl_shm_controller::irsl_float_type> output_;     ///< Output of the last cycle
+    std::vector<irsl_shm_controller::irsl_float_type> prev_output_; ///< Output of the cycle before
+};
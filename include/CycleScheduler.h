@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Deadline accounting of the control loop.
+ */
+struct CycleStatistics
+{
+    uint64_t cycles;           ///< Number of cycles started
+    uint64_t overruns;         ///< Number of cycles started after their deadline
+    uint64_t skipped_cycles;   ///< Number of cycles dropped by the Skip policy
+    int64_t last_overrun_ns;   ///< Lateness of the latest overrun [nsec]
+    int64_t worst_overrun_ns;  ///< Largest lateness [nsec]
+    uint64_t miss_streak;      ///< Number of consecutive overruns up to now
+    uint64_t max_miss_streak;  ///< Longest run of consecutive overruns
+};
+
+/**
+ * @brief Histogram of the wake latency (wake time - deadline).
+ */
+struct WakeHistogram
+{
+    static constexpr int NUM_BUCKETS = 10;
+    static const int64_t BUCKET_LIMITS_NS[NUM_BUCKETS]; ///< Upper limit of each bucket [nsec] (the last one is open)
+
+    uint64_t counts[NUM_BUCKETS]; ///< Number of wakes in each bucket
+    uint64_t samples;             ///< Number of wakes
+    int64_t max_ns;               ///< Largest wake latency [nsec]
+
+    /**
+     * @brief Clears the histogram.
+     */
+    void reset();
+
+    /**
+     * @brief Adds a wake latency.
+     *
+     * @param latency_ns Wake latency [nsec]
+     */
+    void add(int64_t latency_ns);
+
+    /**
+     * @brief Returns the upper limit of the bucket containing the given quantile [nsec].
+     *
+     * @param quantile Quantile (e.g. 0.99)
+     * @return Upper limit of the bucket, max_ns for the open bucket, 0 without samples
+     */
+    int64_t quantile(double quantile) const;
+};
+
+/**
+ * @brief Wakes the control loop at absolute deadlines of CLOCK_MONOTONIC.
+ *
+ * Deadlines are on a fixed grid of the period. When the previous cycle
+ * ends after the next deadline (an overrun), the policy decides when the
+ * next cycle starts.
+ *
+ * A plain sleep wakes 50-100 [usec] late on a kernel without PREEMPT_RT.
+ * With a spin guard, the scheduler sleeps until the guard time before the
+ * deadline and busy-waits for the rest, which costs up to the guard time
+ * of CPU per cycle.
+ */
+class CycleScheduler
+{
+public:
+    /**
+     * @brief What to do when a cycle is late.
+     */
+    enum class OverrunPolicy
+    {
+        CatchUp, ///< Start at once and keep the grid (late cycles run back to back until caught up)
+        Skip,    ///< Drop the missed cycles and wait for the next deadline on the grid
+        Realign  ///< Start at once and move the grid to the current time
+    };
+
+    /**
+     * @brief Constructor for the scheduler class.
+     */
+    CycleScheduler();
+
+    /**
+     * @brief Parses the name of an overrun policy.
+     *
+     * @param name "catch_up", "skip" or "realign"
+     * @param policy Output: Overrun policy
+     * @return true Successful
+     * @return false Unknown name
+     */
+    static bool parsePolicy(const std::string &name, OverrunPolicy &policy);
+
+    /**
+     * @brief Sets the period and the overrun policy.
+     *
+     * @param period_ns Period of the loop [nsec]
+     * @param policy Overrun policy
+     */
+    void initialize(int64_t period_ns, OverrunPolicy policy);
+
+    /**
+     * @brief Sets the busy-wait time before each deadline.
+     *
+     * @param guard_ns Spin guard [nsec] (0: sleep until the deadline)
+     */
+    void setSpinGuard(int64_t guard_ns);
+
+    /**
+     * @brief Starts each cycle as soon as the previous one ends.
+     *
+     * wait() returns at once and no overrun is counted.
+     *
+     * @param free_run true to ignore the deadlines
+     */
+    void setFreeRun(bool free_run);
+
+    /**
+     * @brief Sets the first deadline one period from now and clears the statistics.
+     */
+    void start();
+
+    /**
+     * @brief Waits for the next cycle.
+     *
+     * @return true The cycle starts on time
+     * @return false The cycle is late (an overrun was counted)
+     */
+    bool wait();
+
+    /**
+     * @brief Returns the deadline accounting.
+     */
+    const CycleStatistics &getStatistics() const;
+
+    /**
+     * @brief Returns the wake latency of the cycles started on time since the last reset.
+     */
+    const WakeHistogram &getWakeHistogram() const;
+
+    /**
+     * @brief Clears the wake latency histogram.
+     */
+    void resetWakeHistogram();
+
+    /**
+     * @brief Returns the current CLOCK_MONOTONIC time [nsec].
+     */
+    static int64_t now();
+
+private:
+    void sleepUntil(int64_t deadline_ns) const;
+
+    int64_t period_ns_;
+    OverrunPolicy policy_;
+    int64_t spin_guard_ns_;
+    bool free_run_;
+    int64_t deadline_ns_;
+    CycleStatistics statistics_;
+    WakeHistogram wake_histogram_;
+};
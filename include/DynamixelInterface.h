@@ -3,18 +3,16 @@
 #include <dynamixel_workbench_toolbox/dynamixel_workbench.h>
 #include <iostream>
 #include "irsl/shm_controller.h"
+#include "BusPlanner.h"
 
 #include <yaml-cpp/yaml.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <unordered_map>
 
-// SYNC_WRITE_HANDLER
-static constexpr uint8_t SYNC_WRITE_HANDLER_FOR_GOAL_POSITION = 0;
-static constexpr uint8_t SYNC_WRITE_HANDLER_FOR_GOAL_VELOCITY = 1;
-
-// SYNC_READ_HANDLER(Only for Protocol 2.0)
-static constexpr uint8_t SYNC_READ_HANDLER_FOR_PRESENT_POSITION_VELOCITY_CURRENT = 0;
-
 /**
  * @brief Dynamixel item struct to hold control items and their values.
  *
@@ -38,11 +36,88 @@ struct DynamixelInfo
     uint8_t id;                         ///< id
     std::string comm_group_name;        ///< communication group name
     std::vector<ItemValue> dxl_setting; ///< Dynamixel settings
+    double torque_constant;             ///< torque per unit of current (1.0: torque is reported as current)
+    std::string command_item;           ///< goal item commanded to this joint (e.g. "Goal_Position")
+};
+
+/**
+ * @brief A field of the feedback read window.
+ *
+ * With indirect addressing, every field is packed into one contiguous block
+ * of Indirect Data, and read_address points into that block.
+ */
+struct FeedbackField
+{
+    std::string item_name;       ///< Name of the dynamixel item.
+    const ControlItem *item;     ///< Original control item
+    uint16_t read_address;       ///< Address to read the field from
+    uint16_t data_length;        ///< Length of the field [byte]
+    std::vector<int32_t> values; ///< Latest raw value for each joint (optional fields only)
+};
+
+/**
+ * @brief A commanded goal field.
+ *
+ * With indirect addressing, every goal field is packed into one contiguous
+ * block of Indirect Data and written by a single sync write per group.
+ */
+struct GoalField
+{
+    std::string item_name;       ///< Name of the dynamixel item.
+    const ControlItem *item;     ///< Original control item
+    uint8_t handler_index;        ///< SyncWrite handler used to write the field
+    std::vector<int32_t> values;  ///< Goal value for each joint (raw value)
+    std::vector<int32_t> written; ///< Goal value last written to each joint (raw value)
+};
+
+/**
+ * @brief A sync write packet of goal fields.
+ *
+ * Joints of a communication group are partitioned by their command mode,
+ * so each (group, mode) is written by exactly one packet.
+ */
+struct GoalPartition
+{
+    std::vector<uint8_t> ids;   ///< IDs written by the packet
+    std::vector<size_t> index;  ///< Index in dx_info for each ID
+    size_t first_field;         ///< Index of the first goal field
+    size_t num_fields;          ///< Number of goal fields carried by the packet
+    uint8_t handler_index;      ///< SyncWrite handler used to write the packet
+    size_t skipped_cycles;      ///< Number of consecutive cycles the packet was skipped
+};
+
+/**
+ * @brief A gain item inside the gain write window.
+ */
+struct GainField
+{
+    std::string item_name;   ///< Name of the dynamixel item.
+    const ControlItem *item; ///< Original control item
+    uint16_t offset;         ///< Offset from the start of the gain window [byte]
+};
+
+/**
+ * @brief Auxiliary control item polled at its own rate.
+ *
+ * Auxiliary items (e.g. Present_Temperature) are read one joint at a time,
+ * spread round-robin over control cycles so that the added bus load per
+ * cycle stays constant.
+ */
+struct AuxiliaryItem
+{
+    std::string item_name;                  ///< Name of the dynamixel item.
+    double rate;                            ///< Polling rate for each joint [Hz]
+    std::vector<const ControlItem *> items; ///< Control item for each joint (nullptr if unsupported)
+    std::vector<int32_t> values;            ///< Latest raw value for each joint
+    double reads_per_cycle;                 ///< Number of reads owed to this item per cycle
+    double credit;                          ///< Accumulated reads not issued yet
+    size_t cursor;                          ///< Index of the next joint to read
 };
 
 class DynamixelInterface
 {
 public:
+
     /**
      * @brief Constructor for the interface class.
      *
@@ -61,13 +136,35 @@ public:
     /**
      * @brief Initializes the specified Dynamixels with their initial settings.
      *
-     * Writes the initial settings to the Dynamixels.
+     * Writes the initial settings to the Dynamixels. A Status_Return_Level
+     * lowered by a previous tuned run is first set back to 2. With tune_status_return,
+     * Return_Delay_Time is first lowered to the smallest value at which no
+     * status packet is dropped (see tuneReturnDelay()).
      *
      * @return true All settings were written successfully.
      * @return false Some settings failed to write.
      */
     bool writeInitialSettings();
 
+    /**
+     * @brief Sets the goal items commanded by the controller.
+     *
+     * Must be called before initialize(). Defaults to Goal_Position and Goal_Velocity.
+     *
+     * @param item_names Names of the goal items (e.g. "Goal_Position", "Profile_Velocity")
+     */
+    void setCommandItems(const std::vector<std::string> &item_names);
+
+    /**
+     * @brief Sets the gain items commanded by the controller.
+     *
+     * Must be called before initialize(). Gain items not available on the
+     * connected models are ignored with a warning.
+     *
+     * @param item_names Names of the gain items (e.g. "Position_P_Gain")
+     */
+    void setGainItems(const std::vector<std::string> &item_names);
+
     /**
      * @brief Reads YAML data and initializes Dynamixel settings and initialization.
      *
@@ -148,12 +245,59 @@ public:
      * @param pos_vec Output: Angle data (raw value)
      * @param vel_vec Output: Velocity data (raw value)
      * @param cur_vec Output: Current data (raw value)
+     * @return true Successful
+     * @return false Failed to read some of the data
      */
-    void getDynamixelCurrentStatus(
+    bool getDynamixelCurrentStatus(
         std::vector<int32_t> &pos_vec,
         std::vector<int32_t> &vel_vec,
         std::vector<int32_t> &cur_vec);
 
+    /**
+     * @brief Returns whether the feedback is read through Indirect Data.
+     *
+     * @return true All feedback fields are packed into one Indirect Data block
+     * @return false Feedback is read from Present_Position..Present_Current directly
+     */
+    bool isIndirectFeedback() const;
+
+    /**
+     * @brief Reads this cycle's share of the auxiliary items.
+     *
+     * Each auxiliary item owes (number of joints * rate * period) reads per
+     * cycle. The owed reads are accumulated and issued one joint at a time,
+     * round-robin, so the bus load added to each cycle stays constant.
+     *
+     * @return true All issued reads succeeded
+     * @return false Some reads failed (previous values are kept)
+     */
+    bool pollAuxiliaryItems();
+
+    /**
+     * @brief Retrieves the latest raw values of an auxiliary item.
+     *
+     * Items packed into the feedback window (e.g. Present_Temperature with
+     * indirect addressing) are refreshed every cycle by the sync read.
+     *
+     * @param item_name Name of the auxiliary item (e.g. "Present_Temperature")
+     * @param value_vec Output: Raw value for each joint
+     * @return true The item is polled
+     * @return false The item is not configured
+     */
+    bool getAuxiliaryItem(
+        const std::string &item_name,
+        std::vector<int32_t> &value_vec) const;
+
+    /**
+     * @brief Temperature data (raw value) conversion to degrees Celsius.
+     *
+     * @param temp_vec Input temperature values (Dynamixel raw value)
+     * @param temp_float_vec Output temperature values in degrees Celsius
+     */
+    void convertTemperature(
+        const std::vector<int32_t> &temp_vec,
+        std::vector<irsl_shm_controller::irsl_float_type> &temp_float_vec);
+
     /**
      * @brief Convert angle data (raw value) to radians.
      *
@@ -186,7 +330,7 @@ public:
     /**
      * @brief Torque (current) data is converted.
      *
-     * @note Currently performs the same conversion as convertCurrent
+     * @note Current is multiplied by TorqueConstant of the joint (1.0 by default)
      *
      * @param cur_vec Input current values (Dynamixel raw value)
      * @param torque_float_vec Output torque values (unit undefined)
@@ -195,6 +339,20 @@ public:
         const std::vector<int32_t> &cur_vec,
         std::vector<irsl_shm_controller::irsl_float_type> &torque_float_vec);
 
+    /**
+     * @brief Current data (raw value) conversion to both current and torque.
+     *
+     * Fills both outputs in a single pass over the decoded buffer.
+     *
+     * @param cur_vec Input current values (Dynamixel raw value)
+     * @param cur_float_vec Output current values in user-defined units
+     * @param torque_float_vec Output torque values (unit undefined)
+     */
+    void convertCurrentAndTorque(
+        const std::vector<int32_t> &cur_vec,
+        std::vector<irsl_shm_controller::irsl_float_type> &cur_float_vec,
+        std::vector<irsl_shm_controller::irsl_float_type> &torque_float_vec);
+
     /**
      * @brief Convert position command from radians to raw value.
      *
@@ -211,6 +369,9 @@ public:
     /**
      * @brief Send position command to Dynamixel.
      *
+     * Only the sync writes carrying Goal_Position are sent. With indirect addressing
+     * they also carry the other commanded items, with the values last set.
+     *
      * @param dynamixel_position Input: Position command (raw value)
      * @return true Successful
      * @return false Failed to send command
@@ -235,6 +396,8 @@ public:
      * @brief Transfers velocity command to Dynamixel.
      *
      * Sends the velocity command to the Dynamixel.
+     * Only the sync writes carrying Goal_Velocity are sent. With indirect addressing
+     * they also carry the other commanded items, with the values last set.
      *
      * @param dynamixel_velocity Input: Velocity command (raw value)
      * @return true Successful
@@ -243,22 +406,382 @@ public:
     bool writeVelocity(
         const std::vector<int32_t> &dynamixel_velocity);
 
+    /**
+     * @brief Convert torque command to raw current value.
+     *
+     * Inverse of convertTorque. The result is clamped to Current_Limit of each joint,
+     * and a non-finite command (NaN, infinity) is converted to zero current.
+     *
+     * @param torque_float_vec Input: Torque command (unit of convertTorque)
+     * @param dynamixel_current Output: Raw value for the Dynamixel
+     */
+    void convertTorqueCmd(
+        const std::vector<irsl_shm_controller::irsl_float_type> &torque_float_vec,
+        std::vector<int32_t> &dynamixel_current);
+
+    /**
+     * @brief Transfers current command to Dynamixel.
+     *
+     * Sends the current command (Goal_Current) to the Dynamixel.
+     * Only the sync writes carrying Goal_Current are sent. With indirect addressing
+     * they also carry the other commanded items, with the values last set.
+     *
+     * @param dynamixel_current Input: Current command (raw value)
+     * @return true Successful
+     * @return false Failed to send command
+     */
+    bool writeCurrent(
+        const std::vector<int32_t> &dynamixel_current);
+
+    /**
+     * @brief Sets the goal values of a commanded item without sending them.
+     *
+     * @param item_name Name of the goal item (e.g. "Goal_Position")
+     * @param value_vec Input: Goal value for each joint (raw value)
+     * @return true Successful
+     * @return false The item is not commanded
+     */
+    bool setGoal(
+        const std::string &item_name,
+        const std::vector<int32_t> &value_vec);
+
+    /**
+     * @brief Sends all goal values set by setGoal().
+     *
+     * With indirect addressing, a single sync write per group carries every
+     * commanded item. Otherwise one sync write per item and group is issued.
+     * When joints use different command modes, each joint only receives its
+     * own item, in one sync write per (group, mode).
+     *
+     * A packet is skipped when no goal of its joints moved more than
+     * command_deadband (raw value) from the value last written, unless
+     * command_refresh_cycles have passed since it was last sent.
+     *
+     * @return true Successful
+     * @return false Failed to send command
+     */
+    bool writeGoals();
+
+    /**
+     * @brief Convert gain command to raw value.
+     *
+     * @param gain_float_vec Input: Gain command
+     * @param dynamixel_gain Output: Raw value for the Dynamixel (rounded, non-negative)
+     */
+    void convertGainCmd(
+        const std::vector<irsl_shm_controller::irsl_float_type> &gain_float_vec,
+        std::vector<int32_t> &dynamixel_gain);
+
+    /**
+     * @brief Retrieves the gain values last written to the Dynamixels.
+     *
+     * @param item_name Name of the gain item (e.g. "Position_P_Gain")
+     * @param gain_float_vec Output: Gain value for each joint
+     * @return true Successful
+     * @return false The item is not commanded
+     */
+    bool getGain(
+        const std::string &item_name,
+        std::vector<irsl_shm_controller::irsl_float_type> &gain_float_vec) const;
+
+    /**
+     * @brief Sets the gain values of a commanded item without sending them.
+     *
+     * @param item_name Name of the gain item (e.g. "Position_P_Gain")
+     * @param value_vec Input: Gain value for each joint (raw value)
+     * @return true Successful
+     * @return false The item is not commanded
+     */
+    bool setGain(
+        const std::string &item_name,
+        const std::vector<int32_t> &value_vec);
+
+    /**
+     * @brief Sends the gains set by setGain() to the groups where they changed.
+     *
+     * Gains are compared against the values last written. A group is written
+     * by a single sync write only if one of its joints changed, so nothing
+     * is sent in steady state.
+     *
+     * @return true Successful
+     * @return false Failed to send gains
+     */
+    bool writeGains();
+
+    /**
+     * @brief Predicts the bus time of a cycle from the initialized layout.
+     *
+     * Uses the feedback read window, the goal packets and the auxiliary
+     * reads of each communication group, and the Return_Delay_Time held by
+     * each Dynamixel. Gain writes are excluded, as they are only sent on change.
+     *
+     * @param planner Output: Predicted transactions
+     * @return true Successful
+     * @return false Failed to read Return_Delay_Time (0 is assumed)
+     */
+    bool planBus(BusPlanner &planner);
+
+    /**
+     * @brief Predicts the bus time of a cycle from the configuration only (no bus access).
+     *
+     * Assumes Protocol 2.0 and the control table of the X series. Return_Delay_Time
+     * is taken from DynamixelSettings of each joint, or else the factory default (250).
+     * With max_baud_rate, the bus is assumed to run at the fastest rate it allows.
+     *
+     * @param settings YAML node of the hardware settings
+     * @param command_items Names of the goal items commanded by the controller
+     * @param planner Output: Predicted transactions
+     * @return true Successful
+     * @return false baud_rate or joint is missing
+     */
+    static bool estimateBusPlan(
+        const YAML::Node &settings,
+        const std::vector<std::string> &command_items,
+        BusPlanner &planner);
+
 private:
     /**
-     * @brief Writes a set of values using the specified SyncWrite handler.
+     * @brief Sets the goal values of an item and writes the partitions carrying it.
+     *
+     * @param item_name Name of the goal item (e.g. "Goal_Position")
+     * @param value_vec Input: Goal value for each joint (raw value)
+     * @return true Successful
+     * @return false The item is not commanded, or failed to send command
+     */
+    bool writeGoalItem(
+        const std::string &item_name,
+        const std::vector<int32_t> &value_vec);
+
+    /**
+     * @brief Writes a goal partition using its SyncWrite handler.
      *
-     * This function uses the provided SyncWrite handler index and value vector to
-     * update the Dynamixel's settings. Currently, only two handlers are implemented,
-     * one for goal position and one for goal velocity.
+     * The values of the goal fields carried by the partition are interleaved
+     * for each Dynamixel and sent in one sync write.
      *
-     * @param handler_index Index of the SyncWrite handler to use (0 or 1)
-     * @param value_vector Vector containing the values to write
+     * @param partition Goal partition to write
      * @return true Successful
      * @return false Failed to update Dynamixel settings
      */
     bool writeBySyncHandler(
-        uint8_t handler_index,
-        const std::vector<int32_t> &value_vector);
+        GoalPartition &partition);
+
+    /**
+     * @brief Resolves the goal item commanded to each joint.
+     *
+     * Uses CommandMode of the joint, or else Operating_Mode in its
+     * DynamixelSettings. Falls back to the first commanded item. Mode items
+     * which no joint uses are removed from the goal fields.
+     *
+     * @return true Joints use different goal items
+     * @return false All joints use the same goal item
+     */
+    bool resolveJointCommandItems();
+
+    /**
+     * @brief Returns whether the goal item selects the command mode of a joint.
+     *
+     * @param item_name Name of the goal item
+     * @return true Goal_Position, Goal_Velocity or Goal_Current
+     * @return false Other items (e.g. Profile_Velocity)
+     */
+    static bool isModeItem(const std::string &item_name);
+
+    /**
+     * @brief Returns the goal item of a CommandMode.
+     *
+     * @param mode "Position", "Velocity" or "Current"
+     * @param item_name Output: Name of the goal item
+     * @return true Successful
+     * @return false Unknown mode
+     */
+    static bool parseCommandMode(const std::string &mode, std::string &item_name);
+
+    /**
+     * @brief Returns the goal item of an Operating_Mode.
+     *
+     * @param operating_mode Value of Operating_Mode
+     * @return std::string Name of the goal item (empty for modes without a goal item)
+     */
+    static std::string commandItemOfOperatingMode(int32_t operating_mode);
+
+    /**
+     * @brief Pings every Dynamixel.
+     *
+     * @return true Every Dynamixel answered
+     * @return false Some Dynamixels did not answer
+     */
+    bool pingAll();
+
+    /**
+     * @brief Changes the baud rate of the port.
+     *
+     * @param baud_rate Baud rate
+     * @return true Successful
+     * @return false The adapter does not take the baud rate
+     */
+    bool setPortBaudRate(int32_t baud_rate);
+
+    /**
+     * @brief Looks for the Dynamixels at the rates up to max_baud_rate.
+     *
+     * Used when they do not answer at the configured baud rate, e.g. after
+     * a previous run changed their Baud_Rate.
+     *
+     * @return true Every Dynamixel answered at one of the rates
+     * @return false Not found (the port is set back to the configured rate)
+     */
+    bool findBaudRate();
+
+    /**
+     * @brief Switches every Dynamixel and the port to a baud rate.
+     *
+     * The torque is disabled and Baud_Rate is written by broadcast, then every
+     * Dynamixel must answer a ping twice at the new rate.
+     *
+     * @param baud_rate New baud rate
+     * @param value Baud_Rate value of the new rate
+     * @param baud_rate_address Address of Baud_Rate
+     * @param torque_enable_address Address of Torque_Enable
+     * @return true Every Dynamixel answered at the new rate
+     * @return false Some Dynamixels did not answer
+     */
+    bool switchBaudRate(int32_t baud_rate, uint8_t value, uint16_t baud_rate_address, uint16_t torque_enable_address);
+
+    /**
+     * @brief Switches to the fastest rate up to max_baud_rate that every Dynamixel answers at.
+     *
+     * Rates are tried from the fastest. Rates the adapter does not take are
+     * skipped. When a Dynamixel does not answer at a rate, all are switched
+     * back to the previous rate and the next slower rate is tried.
+     *
+     * @return true Successful (also when the rate is kept)
+     * @return false The Dynamixels do not answer after falling back
+     */
+    bool escalateBaudRate();
+
+    /**
+     * @brief Returns whether the item is given in DynamixelSettings of the joint.
+     */
+    static bool hasSetting(const DynamixelInfo &info, const std::string &item_name);
+
+    /**
+     * @brief Lowers Return_Delay_Time to the smallest value at which no status packet is dropped.
+     *
+     * Each candidate (0, 5, 25, 50, 125, 250) is written to the joints
+     * without Return_Delay_Time in DynamixelSettings, and every communication
+     * group is probed by 20 sync reads (reads on Protocol 1.0).
+     * The first candidate without a failure is kept. The measured time is
+     * printed next to the prediction of BusPlanner.
+     *
+     * @return true Successful
+     * @return false Every candidate dropped status packets
+     */
+    bool tuneReturnDelay();
+
+    /**
+     * @brief Sets Status_Return_Level so that only PING and READ are answered.
+     *
+     * Called at the end of initialize(), as writes are not answered afterwards.
+     * Joints with Status_Return_Level in DynamixelSettings are kept.
+     *
+     * @return true Successful
+     * @return false A Dynamixel did not take the level
+     */
+    bool applyStatusReturnLevel();
+
+    /**
+     * @brief Resolves the goal fields and registers their SyncWrite handlers.
+     *
+     * @return true Successful
+     * @return false A goal item is not available or a handler can not be added
+     */
+    bool initializeGoalFields();
+
+    /**
+     * @brief Resolves the gain fields and registers the SyncWrite handler of the gain window.
+     *
+     * The gain window spans all gain items. Bytes in the window are read from
+     * the Dynamixels, so that items which are not commanded are written back unchanged.
+     *
+     * @return true Successful (also when gains are not available)
+     * @return false A handler can not be added
+     */
+    bool initializeGainFields();
+
+    /**
+     * @brief Maps every goal field into one contiguous Indirect Data block.
+     *
+     * Uses the Indirect Data slots after the feedback block, or the second
+     * Indirect Data bank when they are not enough.
+     *
+     * @return true Successful
+     * @return false Indirect addressing is not available or fields can not be packed
+     */
+    bool initializeIndirectGoal();
+
+    /**
+     * @brief Writes an Indirect Address table to every Dynamixel.
+     *
+     * Torque is disabled while writing and restored afterwards.
+     *
+     * @param table_address Address of the first Indirect Address entry
+     * @param addresses Target address for each entry
+     * @return true Successful
+     * @return false Failed to write
+     */
+    bool writeIndirectAddressTable(
+        uint16_t table_address,
+        const std::vector<uint16_t> &addresses);
+
+    /**
+     * @brief Returns the SyncWrite handler for an address window, adding it on first use.
+     *
+     * Handlers are shared between communication groups, as the IDs are given
+     * to the SDK at each transaction. The SDK holds a limited number of handlers.
+     *
+     * @param address Start address of the window
+     * @param length Length of the window [byte]
+     * @param handler_index Output: Index of the SyncWrite handler
+     * @return true Successful
+     * @return false Failed to add a handler
+     */
+    bool acquireSyncWriteHandler(
+        uint16_t address,
+        uint16_t length,
+        uint8_t &handler_index);
+
+    /**
+     * @brief Returns the SyncRead handler for an address window, adding it on first use.
+     *
+     * @param address Start address of the window
+     * @param length Length of the window [byte]
+     * @param handler_index Output: Index of the SyncRead handler
+     * @return true Successful
+     * @return false Failed to add a handler (e.g. Protocol 1.0)
+     */
+    bool acquireSyncReadHandler(
+        uint16_t address,
+        uint16_t length,
+        uint8_t &handler_index);
+
+    /**
+     * @brief Resolves the control items of the auxiliary items for each joint.
+     *
+     * @return true Successful
+     * @return false An auxiliary item is not available on any joint
+     */
+    bool initializeAuxiliaryItems();
+
+    /**
+     * @brief Maps every feedback field into one contiguous Indirect Data block.
+     *
+     * Writes the Indirect Address table of each Dynamixel. Torque is disabled
+     * while writing and restored afterwards.
+     *
+     * @return true Successful
+     * @return false Indirect addressing is not available (e.g. Protocol 1.0 or mixed models)
+     */
+    bool initializeIndirectFeedback();
 
 private:
     // Dynamixel SDK
@@ -271,7 +794,74 @@ private:
     // Control information
     std::map<std::string, const ControlItem *> control_items_;
 
+    // SDK handlers keyed by (address, length)
+    std::map<std::pair<uint16_t, uint16_t>, uint8_t> sync_write_handlers_;
+    std::map<std::pair<uint16_t, uint16_t>, uint8_t> sync_read_handlers_;
+
+    // Feedback read window
+    // (Present_Position, Present_Velocity, Present_Current come first)
+    bool use_indirect_address_;
+    bool indirect_feedback_;
+    std::vector<FeedbackField> feedback_fields_;
+    uint16_t feedback_address_;
+    uint16_t feedback_length_;
+    uint8_t feedback_handler_index_;
+    std::vector<int32_t> feedback_tmp_;
+
+    // Goal fields written by sync write
+    std::vector<std::string> command_item_names_;
+    bool indirect_goal_;
+    std::vector<GoalField> goal_fields_;
+    std::vector<GoalPartition> goal_partitions_;
+    int32_t command_deadband_;
+    size_t command_refresh_cycles_;
+    std::vector<int32_t> goal_tmp_;
+
+    // Gain window written by sync write when changed
+    // (byte image of the window for each joint)
+    std::vector<std::string> gain_item_names_;
+    std::vector<GainField> gain_fields_;
+    uint16_t gain_address_;
+    uint16_t gain_length_;
+    uint8_t gain_handler_index_;
+    std::vector<uint8_t> gain_pending_;
+    std::vector<uint8_t> gain_written_;
+    std::vector<int32_t> gain_tmp_;
+
+    // Raw Present_Position at 0 [rad] and radian per raw unit above and below it for each joint
+    std::vector<int32_t> position_zero_;
+    std::vector<irsl_shm_controller::irsl_float_type> position_scale_;
+    std::vector<irsl_shm_controller::irsl_float_type> position_scale_negative_;
+    // Velocity per raw unit for each joint, and the raw value above which a
+    // sign and magnitude model reports reverse velocity (0: two's complement)
+    std::vector<irsl_shm_controller::irsl_float_type> velocity_scale_;
+    std::vector<int32_t> velocity_sign_offset_;
+    // Current per raw unit for each joint (resolved once from the model info)
+    std::vector<float> current_scale_;
+    // Torque per raw unit and its inverse for each joint
+    std::vector<irsl_shm_controller::irsl_float_type> torque_scale_;
+    std::vector<irsl_shm_controller::irsl_float_type> torque_scale_inv_;
+    // Current_Limit for each joint (raw value)
+    std::vector<int32_t> current_limit_;
+
     // Communication groups
     std::set<std::string> comm_group_names;
     std::map<std::string, std::vector<uint8_t>> comm_group_id_map;
+
+    // Control period [sec]
+    double control_period_;
+
+    // Baud rate of the bus
+    int32_t baud_rate_;
+    // Host side time per transaction assumed by the bus plan [sec]
+    double transaction_overhead_;
+
+    // Tune Return_Delay_Time and Status_Return_Level at startup
+    bool tune_status_return_;
+
+    // Fastest baud rate switched to after discovery (0: keep baud_rate)
+    int32_t max_baud_rate_;
+
+    // Auxiliary items polled at their own rate
+    std::vector<AuxiliaryItem> aux_items_;
 };
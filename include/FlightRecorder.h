@@ -0,0 +1,199 @@
+#pragma once
+
+#include "irsl/shm_controller.h"
+
+#include "HardwareFrame.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Header at the start of a flight recorder file.
+ */
+struct FlightRecorderHeader
+{
+    uint32_t magic;                       ///< FLIGHT_RECORDER_MAGIC
+    uint32_t version;                     ///< FLIGHT_RECORDER_VERSION
+    uint32_t num_joints;                  ///< Number of joints in each record
+    uint32_t capacity;                    ///< Number of records in the ring
+    uint32_t record_size;                 ///< Size of a record [byte]
+    uint32_t reserved0;                   ///< Padding
+    double period;                        ///< Control period of the recorded session [sec]
+    std::atomic<uint64_t> write_count;    ///< Number of records written
+    std::atomic<uint64_t> last_frame_tag; ///< Shared memory frame of the last record + 1 (0: empty)
+    uint8_t reserved[16];                 ///< Padding to 64 bytes
+};
+
+/**
+ * @brief Fixed part of a record.
+ *
+ * Followed by the per-joint arrays, each num_joints long:
+ * double position, velocity, torque, command_position, command_velocity, command_torque,
+ * int32_t present_position, present_velocity, present_current, present_temperature,
+ * goal_position, goal_velocity, goal_current, hardware_error,
+ * position_p_gain, position_d_gain, velocity_p_gain.
+ */
+struct FlightRecord
+{
+    std::atomic<uint64_t> frame_tag; ///< Shared memory frame + 1 (0 while empty or being written)
+    uint64_t cycle;                  ///< Bus cycle counter
+    int64_t timestamp_ns;            ///< CLOCK_MONOTONIC time of the bus read [nsec]
+    uint32_t flags;                  ///< StateFlag bits
+    uint32_t reserved;               ///< Padding
+};
+
+static constexpr uint32_t FLIGHT_RECORDER_MAGIC = 0x52465844; // "DXFR"
+static constexpr uint32_t FLIGHT_RECORDER_VERSION = 3;
+
+/**
+ * @brief Read-only view of a record.
+ *
+ * The arrays point into storage, a copy of the record owned by the view, so
+ * they stay consistent while the recorder keeps writing.
+ */
+struct FlightRecordView
+{
+    std::vector<uint8_t> storage; ///< Copy of the record
+    uint64_t frame;              ///< Shared memory frame
+    uint64_t cycle;              ///< Bus cycle counter
+    int64_t timestamp_ns;        ///< CLOCK_MONOTONIC time of the bus read [nsec]
+    uint32_t flags;              ///< StateFlag bits
+    const double *position;         ///< Published position [rad]
+    const double *velocity;         ///< Published velocity [rad/s]
+    const double *torque;           ///< Published torque
+    const double *command_position; ///< Position command sent to the joints [rad]
+    const double *command_velocity; ///< Velocity command sent to the joints [rad/s]
+    const double *command_torque;   ///< Torque command sent to the joints
+    const int32_t *present_position;    ///< Present_Position (raw value)
+    const int32_t *present_velocity;    ///< Present_Velocity (raw value)
+    const int32_t *present_current;     ///< Present_Current (raw value)
+    const int32_t *present_temperature; ///< Present_Temperature (raw value)
+    const int32_t *goal_position;       ///< Goal_Position (raw value)
+    const int32_t *goal_velocity;       ///< Goal_Velocity (raw value)
+    const int32_t *goal_current;        ///< Goal_Current (raw value)
+    const int32_t *hardware_error;      ///< Hardware_Error_Status (raw value)
+    const int32_t *position_p_gain;     ///< Position_P_Gain sent to the joints (raw value)
+    const int32_t *position_d_gain;     ///< Position_D_Gain sent to the joints (raw value)
+    const int32_t *velocity_p_gain;     ///< Velocity_P_Gain sent to the joints (raw value)
+};
+
+/**
+ * @brief Records every control cycle into a memory-mapped ring file.
+ *
+ * The file is preallocated, pre-faulted and locked in memory by create(), so
+ * record() is only a few memcpy into the mapping. Records are indexed by the shared memory
+ * frame number (slot = frame % capacity).
+ */
+class FlightRecorder
+{
+public:
+    /**
+     * @brief Constructor for the flight recorder class.
+     */
+    FlightRecorder();
+
+    /**
+     * @brief Destructor for the flight recorder class.
+     */
+    ~FlightRecorder();
+
+    /**
+     * @brief Creates (or truncates) a recorder file for writing.
+     *
+     * @param path Path of the file
+     * @param num_joints Number of joints
+     * @param capacity Number of records in the ring
+     * @param period Control period [sec]
+     * @return true Successful
+     * @return false Failed to create or map the file
+     */
+    bool create(const std::string &path, size_t num_joints, size_t capacity, double period);
+
+    /**
+     * @brief Opens an existing recorder file for reading.
+     *
+     * @param path Path of the file
+     * @return true Successful
+     * @return false Failed to open, or the header does not match
+     */
+    bool open(const std::string &path);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    void close();
+
+    /**
+     * @brief Returns true if a file is mapped.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Writes a record (realtime side).
+     *
+     * @param frame Shared memory frame
+     * @param state Raw state of the cycle
+     * @param position Published position
+     * @param velocity Published velocity
+     * @param torque Published torque
+     * @param command Raw commands of the cycle
+     * @param command_position Position command sent to the joints
+     * @param command_velocity Velocity command sent to the joints
+     * @param command_torque Torque command sent to the joints
+     */
+    void record(uint64_t frame,
+                const StateFrame &state,
+                const std::vector<irsl_shm_controller::irsl_float_type> &position,
+                const std::vector<irsl_shm_controller::irsl_float_type> &velocity,
+                const std::vector<irsl_shm_controller::irsl_float_type> &torque,
+                const CommandFrame &command,
+                const std::vector<irsl_shm_controller::irsl_float_type> &command_position,
+                const std::vector<irsl_shm_controller::irsl_float_type> &command_velocity,
+                const std::vector<irsl_shm_controller::irsl_float_type> &command_torque);
+
+    /**
+     * @brief Returns the record of a shared memory frame.
+     *
+     * The record is copied into the view and the copy is discarded when the
+     * slot was rewritten meanwhile (seqlock), so a file that is still being
+     * recorded can be read.
+     *
+     * @param frame Shared memory frame
+     * @param view Output: The record
+     * @return true Found
+     * @return false The frame is not in the ring, or was overwritten while copied
+     */
+    bool getRecord(uint64_t frame, FlightRecordView &view) const;
+
+    /**
+     * @brief Returns the range of frames that may be in the ring.
+     *
+     * @param first Output: Oldest frame
+     * @param last Output: Latest frame
+     * @return true The ring holds at least one record
+     * @return false The ring is empty
+     */
+    bool getFrameRange(uint64_t &first, uint64_t &last) const;
+
+    /**
+     * @brief Returns the number of joints in each record.
+     */
+    size_t getNumJoints() const;
+
+    /**
+     * @brief Returns the control period of the recorded session [sec].
+     */
+    double getPeriod() const;
+
+private:
+    FlightRecord *recordAt(uint64_t frame) const;
+    bool map(int fd, bool writable);
+
+    void *addr_;
+    size_t size_;
+    size_t num_joints_;
+    FlightRecorderHeader *header_;
+    uint8_t *records_;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Error flags of a bus cycle.
+ */
+enum StateFlag : uint32_t
+{
+    STATE_READ_FAILED = 1u << 0,      ///< Sync read of the feedback failed
+    STATE_AUXILIARY_FAILED = 1u << 1, ///< Reading an auxiliary item failed
+    STATE_GOAL_WRITE_FAILED = 1u << 2, ///< Goal write of the previous cycle failed
+    STATE_GAIN_WRITE_FAILED = 1u << 3, ///< Gain write of the previous cycle failed
+    STATE_OVERRUN = 1u << 4,           ///< The cycle started after its deadline
+    STATE_HARDWARE_ERROR = 1u << 5,    ///< Hardware_Error_Status of a joint is not zero
+};
+
+/**
+ * @brief Raw state read from the Dynamixels in one bus cycle.
+ */
+struct StateFrame
+{
+    uint64_t cycle;                   ///< Bus cycle counter
+    int64_t timestamp_ns;             ///< CLOCK_MONOTONIC time of the read [nsec]
+    uint32_t flags;                   ///< StateFlag bits
+    std::vector<int32_t> position;    ///< Present_Position (raw value)
+    std::vector<int32_t> velocity;    ///< Present_Velocity (raw value)
+    std::vector<int32_t> current;     ///< Present_Current (raw value)
+    std::vector<int32_t> temperature; ///< Present_Temperature (raw value)
+    std::vector<int32_t> hardware_error; ///< Hardware_Error_Status (raw value)
+
+    explicit StateFrame(size_t num_joints = 0)
+        : cycle(0),
+          timestamp_ns(0),
+          flags(0),
+          position(num_joints, 0),
+          velocity(num_joints, 0),
+          current(num_joints, 0),
+          temperature(num_joints, 0),
+          hardware_error(num_joints, 0)
+    {
+    }
+};
+
+/**
+ * @brief Raw commands to be written to the Dynamixels in one bus cycle.
+ */
+struct CommandFrame
+{
+    uint64_t cycle;                       ///< Bus cycle of the state the command was computed from
+    std::vector<int32_t> position;        ///< Goal_Position (raw value)
+    std::vector<int32_t> velocity;        ///< Goal_Velocity (raw value)
+    std::vector<int32_t> current;         ///< Goal_Current (raw value)
+    std::vector<int32_t> position_p_gain; ///< Position_P_Gain (raw value)
+    std::vector<int32_t> position_d_gain; ///< Position_D_Gain (raw value)
+    std::vector<int32_t> velocity_p_gain; ///< Velocity_P_Gain (raw value)
+
+    explicit CommandFrame(size_t num_joints = 0)
+        : cycle(0),
+          position(num_joints, 0),
+          velocity(num_joints, 0),
+          current(num_joints, 0),
+          position_p_gain(num_joints, 0),
+          position_d_gain(num_joints, 0),
+          velocity_p_gain(num_joints, 0)
+    {
+    }
+};
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "CycleScheduler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Status of the control loop published in a companion shared memory segment.
+ *
+ * Only written by robot_hardware. Counters are updated every cycle, so a
+ * controller can react to overruns without measuring the lag itself.
+ */
+struct LoopStatusBlock
+{
+    uint32_t magic;                          ///< LOOP_STATUS_MAGIC
+    uint32_t version;                        ///< LOOP_STATUS_VERSION
+    int64_t period_ns;                       ///< Period of the loop [nsec]
+    std::atomic<uint64_t> cycles;            ///< Number of cycles started
+    std::atomic<uint64_t> overruns;          ///< Number of cycles started after their deadline
+    std::atomic<uint64_t> skipped_cycles;    ///< Number of cycles dropped by the skip policy
+    std::atomic<int64_t> last_overrun_ns;    ///< Lateness of the latest overrun [nsec]
+    std::atomic<int64_t> worst_overrun_ns;   ///< Largest lateness [nsec]
+    std::atomic<uint64_t> miss_streak;       ///< Number of consecutive overruns up to now (0: on time)
+    std::atomic<uint64_t> max_miss_streak;   ///< Longest run of consecutive overruns
+    uint32_t overrun_policy;                 ///< 0: catch_up, 1: skip, 2: realign
+    uint32_t free_run;                       ///< 1: the loop does not wait for deadlines
+    std::atomic<int64_t> mean_cycle_ns;      ///< Mean cycle time of the last report window [nsec]
+    std::atomic<int64_t> read_ns;            ///< Time of the latest feedback read [nsec]
+    std::atomic<int64_t> auxiliary_ns;       ///< Time of the latest auxiliary reads [nsec]
+    std::atomic<int64_t> write_ns;           ///< Time of the latest gain and goal writes [nsec]
+    std::atomic<int64_t> frame_timestamp_ns; ///< CLOCK_MONOTONIC time of the bus read of the latest frame [nsec]
+    std::atomic<uint64_t> frame;             ///< Latest shared memory frame (stored last)
+    uint32_t lockstep;                       ///< 1: each cycle is triggered by the controller
+    std::atomic<uint32_t> command_sequence;  ///< Futex word incremented by the controller after writing a command
+    std::atomic<uint32_t> state_sequence;    ///< Futex word incremented by robot_hardware after each shared memory frame
+    uint8_t reserved[116];                   ///< Padding to 256 bytes
+};
+
+static constexpr uint32_t LOOP_STATUS_MAGIC = 0x53545844; // "DXTS"
+static constexpr uint32_t LOOP_STATUS_VERSION = 3;
+
+/**
+ * @brief Loop status segment "/irsl_dynamixel_status_<shm_key>".
+ *
+ * robot_hardware creates the segment. A consumer in another process opens
+ * it to block until a new frame is published, and a controller signals
+ * commands through it in lockstep mode.
+ */
+class LoopStatus
+{
+public:
+    /**
+     * @brief Constructor for the loop status class.
+     */
+    LoopStatus();
+
+    /**
+     * @brief Destructor for the loop status class.
+     *
+     * Unmaps the segment and removes it.
+     */
+    ~LoopStatus();
+
+    /**
+     * @brief Creates the shared memory segment.
+     *
+     * @param name Name of the POSIX shared memory (e.g. "/irsl_dynamixel_status_8888")
+     * @param period_ns Period of the loop [nsec]
+     * @param policy Overrun policy of the loop
+     * @param free_run The loop does not wait for deadlines
+     * @param lockstep Each cycle is triggered by the controller
+     * @return true Successful
+     * @return false Failed to create or map the segment
+     */
+    bool create(const std::string &name, int64_t period_ns, CycleScheduler::OverrunPolicy policy, bool free_run, bool lockstep);
+
+    /**
+     * @brief Opens the segment created by robot_hardware.
+     *
+     * @param name Name of the POSIX shared memory
+     * @return true Successful
+     * @return false The segment does not exist or is of another version
+     */
+    bool open(const std::string &name);
+
+    /**
+     * @brief Unmaps the segment.
+     */
+    void close();
+
+    /**
+     * @brief Publishes the deadline accounting of the scheduler.
+     *
+     * @param statistics Deadline accounting
+     */
+    void update(const CycleStatistics &statistics);
+
+    /**
+     * @brief Publishes the bus time of the latest cycle.
+     *
+     * @param read_ns Time of the feedback read [nsec]
+     * @param auxiliary_ns Time of the auxiliary reads [nsec]
+     * @param write_ns Time of the gain and goal writes [nsec]
+     */
+    void updateTransactions(int64_t read_ns, int64_t auxiliary_ns, int64_t write_ns);
+
+    /**
+     * @brief Publishes the mean cycle time of a report window.
+     *
+     * @param mean_cycle_ns Mean cycle time [nsec]
+     */
+    void updateCycleTime(int64_t mean_cycle_ns);
+
+    /**
+     * @brief Publishes the shared memory frame and the time of its bus read.
+     *
+     * @param frame Shared memory frame
+     * @param timestamp_ns CLOCK_MONOTONIC time of the bus read [nsec]
+     */
+    void updateFrame(uint64_t frame, int64_t timestamp_ns);
+
+    /**
+     * @brief Returns the current command sequence.
+     */
+    uint32_t getCommandSequence() const;
+
+    /**
+     * @brief Returns the current state sequence.
+     */
+    uint32_t getStateSequence() const;
+
+    /**
+     * @brief Waits until the controller signals a command (robot_hardware side).
+     *
+     * @param sequence In: Last command sequence seen, Out: Current command sequence
+     * @param timeout_ns Timeout [nsec]
+     * @return true A command was signaled since sequence
+     * @return false Timed out
+     */
+    bool waitCommand(uint32_t &sequence, int64_t timeout_ns);
+
+    /**
+     * @brief Signals that a new frame is in the shared memory (robot_hardware side).
+     */
+    void signalState();
+
+    /**
+     * @brief Signals that a new command is in the shared memory (controller side).
+     */
+    void signalCommand();
+
+    /**
+     * @brief Waits until robot_hardware publishes a new frame (consumer side).
+     *
+     * @param sequence In: Last state sequence seen, Out: Current state sequence
+     * @param timeout_ns Timeout [nsec]
+     * @return true A state was signaled since sequence
+     * @return false Timed out
+     */
+    bool waitState(uint32_t &sequence, int64_t timeout_ns);
+
+private:
+    static bool waitSequence(std::atomic<uint32_t> &word, uint32_t &sequence, int64_t timeout_ns);
+    static void signalSequence(std::atomic<uint32_t> &word);
+
+    std::string name_;
+    LoopStatusBlock *block_;
+    bool owner_;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+/**
+ * @brief Logs an error to stderr from the realtime path, at most once a second per call site.
+ */
+#define RT_LOG_ERROR(...)                                                                           \
+    do                                                                                              \
+    {                                                                                               \
+        static RealtimeLogger::RateLimit rt_log_limit_(RealtimeLogger::DEFAULT_RATE_LIMIT_NS);      \
+        RealtimeLogger::instance().logLimited(rt_log_limit_, RealtimeLogger::Err, __VA_ARGS__);     \
+    } while (0)
+
+/**
+ * @brief Non-blocking logger for the realtime path.
+ *
+ * Messages are formatted into preallocated slots of a bounded lock-free queue
+ * and written to stdout/stderr by a background thread, so the caller never
+ * waits for the console. Messages that do not fit in the queue are dropped and
+ * counted. Before start() (and after stop()) messages are written directly.
+ */
+class RealtimeLogger
+{
+public:
+    static constexpr int64_t DEFAULT_RATE_LIMIT_NS = 1000000000LL; ///< 1 message per second
+    static constexpr size_t MESSAGE_LENGTH = 256;                  ///< Including the terminating null
+
+    /**
+     * @brief Output stream of a message.
+     */
+    enum Stream
+    {
+        Out, ///< stdout
+        Err, ///< stderr
+    };
+
+    /**
+     * @brief Rate limit state of one message site.
+     */
+    struct RateLimit
+    {
+        int64_t interval_ns;              ///< Minimum interval between messages [nsec]
+        std::atomic<int64_t> next_ns;     ///< Earliest time of the next message [nsec]
+        std::atomic<uint32_t> suppressed; ///< Messages suppressed since the last one
+
+        explicit RateLimit(int64_t interval)
+            : interval_ns(interval), next_ns(0), suppressed(0)
+        {
+        }
+    };
+
+    /**
+     * @brief Returns the process-wide logger.
+     */
+    static RealtimeLogger &instance();
+
+    /**
+     * @brief Starts the background writer thread.
+     *
+     * @param capacity Number of queued messages (rounded up to a power of two)
+     * @return true Started
+     * @return false Already running
+     */
+    bool start(size_t capacity = 1024);
+
+    /**
+     * @brief Writes the queued messages and stops the background writer thread.
+     */
+    void stop();
+
+    /**
+     * @brief Queues a printf style message.
+     *
+     * @param stream Output stream
+     * @param format printf format (a newline is appended)
+     */
+    void log(Stream stream, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+    /**
+     * @brief Queues a printf style message unless the site logged within its interval.
+     *
+     * The number of suppressed messages is appended to the next message of the site.
+     *
+     * @param limit Rate limit state of the message site
+     * @param stream Output stream
+     * @param format printf format (a newline is appended)
+     */
+    void logLimited(RateLimit &limit, Stream stream, const char *format, ...) __attribute__((format(printf, 4, 5)));
+
+    /**
+     * @brief Returns the number of messages dropped because the queue was full.
+     */
+    uint64_t getDroppedMessages() const;
+
+private:
+    struct Message
+    {
+        std::atomic<size_t> sequence; ///< Slot state (Vyukov bounded queue)
+        Stream stream;
+        char text[MESSAGE_LENGTH];
+    };
+
+    RealtimeLogger();
+    ~RealtimeLogger();
+    RealtimeLogger(const RealtimeLogger &) = delete;
+    RealtimeLogger &operator=(const RealtimeLogger &) = delete;
+
+    void vlog(Stream stream, uint32_t suppressed, const char *format, va_list args);
+    static void formatMessage(char *text, uint32_t suppressed, const char *format, va_list args);
+    bool pop(Stream &stream, char *text);
+    void run();
+    static void write(Stream stream, const char *text);
+
+    std::unique_ptr<Message[]> messages_;
+    size_t mask_;
+    std::atomic<bool> running_;
+    std::atomic<uint32_t> producers_; ///< Threads between the running_ check and the publish of a message
+    std::atomic<uint64_t> dropped_;
+    std::thread thread_;
+    alignas(64) std::atomic<size_t> enqueue_pos_;
+    alignas(64) std::atomic<size_t> dequeue_pos_;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Wait-free single-producer/single-consumer ring of preallocated slots.
+ *
+ * Slots are copies of a prototype, so elements holding vectors are allocated
+ * once and only overwritten afterwards. The producer fills the slot returned
+ * by acquire() in place and calls publish(); the consumer reads front() in
+ * place and calls pop().
+ */
+template <typename T>
+class SpscRing
+{
+public:
+    /**
+     * @brief Constructor for the ring class.
+     *
+     * @param capacity Number of slots (rounded up to a power of two)
+     * @param prototype Initial value of every slot
+     */
+    SpscRing(size_t capacity, const T &prototype)
+        : slots_(roundUpPowerOfTwo(capacity), prototype),
+          mask_(slots_.size() - 1),
+          head_(0),
+          tail_(0)
+    {
+    }
+
+    /**
+     * @brief Returns the slot to be written next (producer only).
+     *
+     * @return T* Free slot, or nullptr when the ring is full
+     */
+    T *acquire()
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= slots_.size())
+        {
+            return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+
+    /**
+     * @brief Makes the slot returned by acquire() visible to the consumer (producer only).
+     */
+    void publish()
+    {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Returns the oldest published slot (consumer only).
+     *
+     * @return T* Oldest slot, or nullptr when the ring is empty
+     */
+    T *front()
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &slots_[tail & mask_];
+    }
+
+    /**
+     * @brief Releases the slot returned by front() (consumer only).
+     */
+    void pop()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    static size_t roundUpPowerOfTwo(size_t n)
+    {
+        size_t p = 1;
+        while (p < n)
+        {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    std::vector<T> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_; ///< Written by the producer
+    alignas(64) std::atomic<size_t> tail_; ///< Written by the consumer
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "irsl/shm_controller.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Header of the trajectory ring placed at the start of the shared memory segment.
+ *
+ * The ring is single-producer (client) / single-consumer (robot_hardware).
+ * write_index is only written by the client, read_index only by robot_hardware.
+ */
+struct TrajectoryRingHeader
+{
+    uint32_t magic;                   ///< TRAJECTORY_RING_MAGIC
+    uint32_t version;                 ///< TRAJECTORY_RING_VERSION
+    uint32_t num_joints;              ///< Number of joints in each segment
+    uint32_t capacity;                ///< Number of segments in the ring
+    std::atomic<uint64_t> write_index; ///< Number of segments pushed by the client
+    std::atomic<uint64_t> read_index;  ///< Index of the active segment (write_index: released)
+    uint8_t reserved[32];             ///< Padding to 64 bytes
+};
+
+static constexpr uint32_t TRAJECTORY_RING_MAGIC = 0x52545844; // "DXTR"
+static constexpr uint32_t TRAJECTORY_RING_VERSION = 1;
+
+/**
+ * @brief Trajectory streaming buffer in a companion shared memory segment.
+ *
+ * A client pushes timestamped cubic segments
+ * (q(t) = c0 + c1 t + c2 t^2 + c3 t^3 for t in [0, duration]),
+ * and robot_hardware evaluates the active segment every cycle.
+ * Timestamps are CLOCK_MONOTONIC seconds.
+ *
+ * Segment layout: double start_time, double duration, double coeffs[num_joints][4]
+ */
+class TrajectoryBuffer
+{
+public:
+    /**
+     * @brief Constructor for the trajectory buffer class.
+     */
+    TrajectoryBuffer();
+
+    /**
+     * @brief Destructor for the trajectory buffer class.
+     *
+     * Unmaps the segment, and removes it if it was created by this instance.
+     */
+    ~TrajectoryBuffer();
+
+    /**
+     * @brief Creates the shared memory segment (robot_hardware side).
+     *
+     * @param name Name of the POSIX shared memory (e.g. "/irsl_dynamixel_trajectory_8888")
+     * @param num_joints Number of joints
+     * @param capacity Number of segments in the ring
+     * @return true Successful
+     * @return false Failed to create or map the segment
+     */
+    bool create(const std::string &name, size_t num_joints, size_t capacity);
+
+    /**
+     * @brief Opens an existing shared memory segment (client side).
+     *
+     * @param name Name of the POSIX shared memory
+     * @return true Successful
+     * @return false Failed to open, or the header does not match
+     */
+    bool open(const std::string &name);
+
+    /**
+     * @brief Unmaps the segment.
+     */
+    void close();
+
+    /**
+     * @brief Pushes a segment (client side).
+     *
+     * @param start_time Start time of the segment [sec, CLOCK_MONOTONIC]
+     * @param duration Duration of the segment [sec]
+     * @param coeffs Cubic coefficients, num_joints * 4 values ordered as [joint][power]
+     * @return true Successful
+     * @return false The ring is full
+     */
+    bool push(double start_time, double duration, const double *coeffs);
+
+    /**
+     * @brief Evaluates the trajectory at the given time (robot_hardware side).
+     *
+     * Advances to the latest segment that has started. Between segments,
+     * the final position of the previous one is held. When the last segment
+     * has ended and no other is queued, its final position is returned once
+     * and the trajectory is released (read_index = write_index).
+     *
+     * @param now Current time [sec, CLOCK_MONOTONIC]
+     * @param pos_vec Output: Position for each joint
+     * @return true A segment is active
+     * @return false No segment has started yet, or the trajectory was released
+     */
+    bool evaluate(double now, std::vector<irsl_shm_controller::irsl_float_type> &pos_vec);
+
+    /**
+     * @brief Returns the current CLOCK_MONOTONIC time in seconds.
+     */
+    static double now();
+
+    /**
+     * @brief Returns the number of joints in each segment.
+     */
+    size_t getNumJoints() const;
+
+private:
+    double *segmentAt(uint64_t index) const;
+
+    std::string name_;
+    bool owner_;
+    void *addr_;
+    size_t size_;
+    size_t stride_; ///< Number of doubles in a segment
+    TrajectoryRingHeader *header_;
+    double *segments_;
+};
@@ -0,0 +1,41 @@
+import sys
+sys.path.append("/usr/local/share/irsl_shm_controller")
+
+import irsl_shm
+from loop_sync import LoopSync
+
+ss = irsl_shm.ShmSettings()
+ss.hash = 8888
+ss.shm_key = 8888
+ss.numJoints = 5
+ss.numForceSensors = 0
+ss.numImuSensors = 0
+ss.jointType = irsl_shm.JointType.PositionCommand | irsl_shm.JointType.PositionGains
+sm = irsl_shm.ShmManager(ss)
+
+res = sm.openSharedMemory(False)
+print(res)
+
+# robot_hardware must be started with --lockstep
+sync = LoopSync(ss.shm_key)
+sequence = sync.state_sequence()
+
+delta = 0.05
+pos = sm.readPositionCurrent()
+for i in range(100):
+    # one command, one bus cycle, one state
+    for j in range(len(pos)):
+        if abs(pos[j]) <= delta:
+            pos[j] = 0.0
+        elif pos[j] > 0:
+            pos[j] -= delta
+        else:
+            pos[j] += delta
+    sm.writePositionCommand(pos)
+    sync.signal_command()
+    sequence = sync.wait_state(sequence, 1.0)
+    if sequence is None:
+        print("robot_hardware did not answer")
+        break
+    pos = sm.readPositionCurrent()
+    print(sm.getFrame(), pos)
@@ -0,0 +1,31 @@
+import mmap
+import struct
+import sys
+import time
+
+# layout of LoopStatusBlock (include/LoopStatus.h)
+STATUS_FORMAT = "<IIqQQQqqQQIIqqqqqQI"
+STATUS_SIZE = 256
+MAGIC = 0x53545844
+POLICIES = ["catch_up", "skip", "realign"]
+
+shm_key = int(sys.argv[1]) if len(sys.argv) > 1 else 8888
+
+f = open("/dev/shm/irsl_dynamixel_status_%d" % shm_key, "rb")
+buf = mmap.mmap(f.fileno(), STATUS_SIZE, access=mmap.ACCESS_READ)
+
+while True:
+    (magic, version, period_ns, cycles, overruns, skipped, last_overrun_ns, worst_overrun_ns,
+     miss_streak, max_miss_streak, policy, free_run, mean_cycle_ns, read_ns, auxiliary_ns, write_ns,
+     frame_timestamp_ns, frame, lockstep) = struct.unpack_from(STATUS_FORMAT, buf, 0)
+    assert magic == MAGIC
+    if free_run or lockstep:
+        print(("lockstep" if lockstep else "free run") + " %.1f [Hz], read %d, auxiliary %d, write %d [usec], frame %d at %.6f [sec]" %
+              (1e9 / mean_cycle_ns if mean_cycle_ns > 0 else 0.0, read_ns // 1000, auxiliary_ns // 1000,
+               write_ns // 1000, frame, frame_timestamp_ns * 1e-9))
+        time.sleep(1.0)
+        continue
+    print("period %d [usec] (%s), cycles %d, overruns %d, skipped %d, last %d [usec], worst %d [usec], streak %d (max %d)" %
+          (period_ns // 1000, POLICIES[policy], cycles, overruns, skipped,
+           last_overrun_ns // 1000, worst_overrun_ns // 1000, miss_streak, max_miss_streak))
+    time.sleep(1.0)
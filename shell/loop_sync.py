@@ -0,0 +1,56 @@
+import ctypes
+import mmap
+import platform
+import struct
+import time
+
+# layout of LoopStatusBlock (include/LoopStatus.h)
+STATUS_SIZE = 256
+MAGIC = 0x53545844
+VERSION = 3
+COMMAND_SEQUENCE_OFFSET = 132
+STATE_SEQUENCE_OFFSET = 136
+
+SYS_FUTEX = {"x86_64": 202, "aarch64": 98}[platform.machine()]
+FUTEX_WAIT = 0
+FUTEX_WAKE = 1
+
+libc = ctypes.CDLL(None, use_errno=True)
+libc.syscall.restype = ctypes.c_long
+
+
+class Timespec(ctypes.Structure):
+    _fields_ = [("tv_sec", ctypes.c_long), ("tv_nsec", ctypes.c_long)]
+
+
+class LoopSync:
+    """ futex words of /irsl_dynamixel_status_<shm_key> """
+
+    def __init__(self, shm_key):
+        self.f = open("/dev/shm/irsl_dynamixel_status_%d" % shm_key, "r+b")
+        self.buf = mmap.mmap(self.f.fileno(), STATUS_SIZE)
+        magic, version = struct.unpack_from("<II", self.buf, 0)
+        assert magic == MAGIC and version == VERSION
+        self.command_word = ctypes.c_uint32.from_buffer(self.buf, COMMAND_SEQUENCE_OFFSET)
+        self.state_word = ctypes.c_uint32.from_buffer(self.buf, STATE_SEQUENCE_OFFSET)
+
+    def state_sequence(self):
+        return self.state_word.value
+
+    def signal_command(self):
+        """ call after writing a command to the shared memory (only the controller writes the word) """
+        self.command_word.value = (self.command_word.value + 1) & 0xFFFFFFFF
+        libc.syscall(SYS_FUTEX, ctypes.byref(self.command_word), FUTEX_WAKE, 0x7FFFFFFF, None, None, 0)
+
+    def wait_state(self, sequence, timeout):
+        """ blocks until a frame is published after sequence, returns the new sequence, or None on timeout """
+        deadline = time.monotonic() + timeout
+        while True:
+            current = self.state_word.value
+            if current != sequence:
+                return current
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                return None
+            ts = Timespec(int(remaining), int((remaining % 1.0) * 1e9))
+            libc.syscall(SYS_FUTEX, ctypes.byref(self.state_word), FUTEX_WAIT, current, ctypes.byref(ts), None, 0)
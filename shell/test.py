@@ -4,6 +4,7 @@ sys.path.append("/usr/local/share/irsl_shm_controller")
 import irsl_shm
 import numpy as np
 import time
+from loop_sync import LoopSync
 
 ss = irsl_shm.ShmSettings()
 ss.hash = 8888
@@ -22,6 +23,10 @@ print(res)
 res = sm.isOpen()
 print(res)
 
+# blocks until robot_hardware publishes a new frame instead of polling getFrame()
+sync = LoopSync(ss.shm_key)
+sequence = sync.state_sequence()
+
 delta = 0.05
 
 for i in range(100):
@@ -37,4 +42,7 @@ for i in range(100):
     print(pos)
     ret = sm.writePositionCommand(pos)
     print(ret)
-    time.sleep(0.01)
+    sequence = sync.wait_state(sequence, 1.0)
+    if sequence is None:
+        print("no new frame")
+        break
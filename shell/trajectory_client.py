@@ -0,0 +1,80 @@
+import sys
+sys.path.append("/usr/local/share/irsl_shm_controller")
+
+import irsl_shm
+import mmap
+import struct
+import time
+
+# layout of TrajectoryRingHeader (include/TrajectoryBuffer.h)
+HEADER_FORMAT = "<IIIIQQ"
+HEADER_SIZE = 64
+MAGIC = 0x52545844
+WRITE_INDEX_OFFSET = 16
+READ_INDEX_OFFSET = 24
+
+ss = irsl_shm.ShmSettings()
+ss.hash = 8888
+ss.shm_key = 8888
+ss.numJoints = 5
+ss.numForceSensors = 0
+ss.numImuSensors = 0
+ss.jointType = irsl_shm.JointType.PositionCommand | irsl_shm.JointType.PositionGains
+sm = irsl_shm.ShmManager(ss)
+
+res = sm.openSharedMemory(False)
+print(res)
+
+# robot_hardware must be started with --trajectory
+f = open("/dev/shm/irsl_dynamixel_trajectory_%d" % ss.shm_key, "r+b")
+buf = mmap.mmap(f.fileno(), 0)
+magic, version, num_joints, capacity, write_index, read_index = struct.unpack_from(HEADER_FORMAT, buf, 0)
+print(hex(magic), version, num_joints, capacity)
+assert magic == MAGIC
+stride = 8 * (2 + num_joints * 4)
+
+
+def push(start_time, duration, coeffs):
+    """ coeffs: [[c0, c1, c2, c3] for each joint], q(t) = c0 + c1 t + c2 t^2 + c3 t^3 """
+    write_index = struct.unpack_from("<Q", buf, WRITE_INDEX_OFFSET)[0]
+    read_index = struct.unpack_from("<Q", buf, READ_INDEX_OFFSET)[0]
+    if write_index - read_index >= capacity:
+        return False
+    offset = HEADER_SIZE + (write_index % capacity) * stride
+    values = [start_time, duration] + [c for joint in coeffs for c in joint]
+    struct.pack_into("<%dd" % len(values), buf, offset, *values)
+    # the segment is written before the index (stores are not reordered on x86)
+    struct.pack_into("<Q", buf, WRITE_INDEX_OFFSET, write_index + 1)
+    return True
+
+
+def released():
+    """ robot_hardware releases the trajectory after the last queued segment ended """
+    write_index, read_index = struct.unpack_from("<QQ", buf, WRITE_INDEX_OFFSET)
+    return read_index == write_index
+
+
+def cubic(q0, q1, T):
+    """ rest-to-rest cubic from q0 to q1 in T seconds """
+    d = q1 - q0
+    return [q0, 0.0, 3.0 * d / (T * T), -2.0 * d / (T * T * T)]
+
+
+# move every joint to 0.0 and back, 2 seconds each, pushed at low rate
+T = 2.0
+pos = sm.readPositionCurrent()
+targets = [[0.0] * num_joints, list(pos)]
+start = time.clock_gettime(time.CLOCK_MONOTONIC) + 0.1
+q0 = list(pos)
+for q1 in targets:
+    coeffs = [cubic(q0[j], q1[j], T) for j in range(num_joints)]
+    while not push(start, T, coeffs):
+        time.sleep(0.1)
+    start += T
+    q0 = q1
+
+while not released():
+    print(sm.getFrame(), sm.readPositionCurrent())
+    time.sleep(0.5)
+# the final position was written to the PositionCommand channel, which drives the joints again
+print("released", sm.readPositionCommand())
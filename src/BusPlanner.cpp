@@ -0,0 +1,173 @@
+#include "BusPlanner.h"
+
+#include <iomanip>
+
+namespace
+{
+    // Return_Delay_Time is 2 [usec] per unit
+    const double RETURN_DELAY_UNIT = 2e-6;
+}
+
+BusPlanner::BusPlanner()
+    : baud_rate_(0),
+      protocol_version_(2.0f),
+      overhead_(0.0)
+{
+}
+
+void BusPlanner::setBus(int32_t baud_rate, float protocol_version)
+{
+    baud_rate_ = baud_rate;
+    protocol_version_ = protocol_version;
+    transactions_.clear();
+}
+
+void BusPlanner::setTransactionOverhead(double overhead)
+{
+    overhead_ = overhead;
+    for (auto &t : transactions_)
+    {
+        t.time = wireTime(t.request_bytes + t.response_bytes) + t.return_delay + overhead_;
+    }
+}
+
+size_t BusPlanner::instructionSize(size_t num_params) const
+{
+    if (protocol_version_ == 2.0f)
+    {
+        // FF FF FD 00 ID LEN(2) INST PARAMS CRC(2)
+        return 10 + num_params;
+    }
+    // FF FF ID LEN INST PARAMS CHECKSUM
+    return 6 + num_params;
+}
+
+size_t BusPlanner::statusSize(size_t num_params) const
+{
+    if (protocol_version_ == 2.0f)
+    {
+        // FF FF FD 00 ID LEN(2) 0x55 ERR PARAMS CRC(2)
+        return 11 + num_params;
+    }
+    // FF FF ID LEN ERR PARAMS CHECKSUM
+    return 6 + num_params;
+}
+
+void BusPlanner::addTransaction(const std::string &name, double per_cycle, size_t request_bytes, size_t response_bytes, double return_delay)
+{
+    BusTransaction t{name, per_cycle, request_bytes, response_bytes, return_delay, 0.0};
+    t.time = wireTime(request_bytes + response_bytes) + return_delay + overhead_;
+    transactions_.push_back(t);
+}
+
+void BusPlanner::addSyncRead(const std::string &name, const std::vector<int32_t> &return_delay_times, uint16_t data_length)
+{
+    if (return_delay_times.empty())
+    {
+        return;
+    }
+    if (protocol_version_ != 2.0f)
+    {
+        for (int32_t return_delay_time : return_delay_times)
+        {
+            addRead(name, return_delay_time, data_length, 1.0);
+        }
+        return;
+    }
+
+    double return_delay = 0.0;
+    for (int32_t return_delay_time : return_delay_times)
+    {
+        return_delay += return_delay_time * RETURN_DELAY_UNIT;
+    }
+    // ADDR(2) LEN(2) ID * N
+    size_t request = instructionSize(4 + return_delay_times.size());
+    size_t response = statusSize(data_length) * return_delay_times.size();
+    addTransaction(name, 1.0, request, response, return_delay);
+}
+
+void BusPlanner::addSyncWrite(const std::string &name, size_t num_ids, uint16_t data_length)
+{
+    if (num_ids == 0)
+    {
+        return;
+    }
+    // ADDR LEN (1 byte each on Protocol 1.0, 2 bytes each on 2.0) and (ID DATA) * N
+    size_t header = (protocol_version_ == 2.0f) ? 4 : 2;
+    addTransaction(name, 1.0, instructionSize(header + num_ids * (1 + data_length)), 0, 0.0);
+}
+
+void BusPlanner::addRead(const std::string &name, int32_t return_delay_time, uint16_t data_length, double per_cycle)
+{
+    if (per_cycle <= 0.0)
+    {
+        return;
+    }
+    size_t params = (protocol_version_ == 2.0f) ? 4 : 2;
+    addTransaction(name, per_cycle, instructionSize(params), statusSize(data_length), return_delay_time * RETURN_DELAY_UNIT);
+}
+
+const std::vector<BusTransaction> &BusPlanner::getTransactions() const
+{
+    return transactions_;
+}
+
+double BusPlanner::getCycleTime() const
+{
+    double cycle_time = 0.0;
+    for (const auto &t : transactions_)
+    {
+        cycle_time += t.time * t.per_cycle;
+    }
+    return cycle_time;
+}
+
+double BusPlanner::getMaxRate() const
+{
+    double cycle_time = getCycleTime();
+    return (cycle_time > 0.0) ? 1.0 / cycle_time : 0.0;
+}
+
+double BusPlanner::getUtilization(double period) const
+{
+    return (period > 0.0) ? getCycleTime() / period : 0.0;
+}
+
+double BusPlanner::wireTime(size_t bytes) const
+{
+    // 1 start bit, 8 data bits, 1 stop bit
+    return (baud_rate_ > 0) ? bytes * 10.0 / baud_rate_ : 0.0;
+}
+
+void BusPlanner::print(std::ostream &os, double period) const
+{
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << std::fixed << std::setprecision(1);
+
+    os << "Bus plan : baud rate " << baud_rate_ << ", protocol " << protocol_version_;
+    if (overhead_ > 0.0)
+    {
+        os << ", overhead " << overhead_ * 1e6 << " [usec] per transaction";
+    }
+    os << std::endl;
+    for (const auto &t : transactions_)
+    {
+        os << "  " << t.name << " : request " << t.request_bytes << " [byte], response " << t.response_bytes
+           << " [byte], return delay " << t.return_delay * 1e6 << " [usec], " << t.time * 1e6 << " [usec]";
+        if (t.per_cycle != 1.0)
+        {
+            os << std::setprecision(3) << " x " << t.per_cycle << std::setprecision(1);
+        }
+        os << std::endl;
+    }
+    os << "  cycle time " << getCycleTime() * 1e6 << " [usec], max rate " << getMaxRate() << " [Hz]";
+    if (period > 0.0)
+    {
+        os << ", utilization " << getUtilization(period) * 100.0 << " [%] of period " << period * 1e6 << " [usec]";
+    }
+    os << std::endl;
+
+    os.flags(flags);
+    os.precision(precision);
+}
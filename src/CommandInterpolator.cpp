@@ -0,0 +1,118 @@
+#include "CommandInterpolator.h"
+
+#include <algorithm>
+
+CommandInterpolator::CommandInterpolator()
+    : method_(Method::Hold),
+      cycles_per_command_(1.0),
+      step_(1.0),
+      s_(1.0)
+{
+}
+
+bool CommandInterpolator::parseMethod(const std::string &name, Method &method)
+{
+    if (name == "hold")
+        method = Method::Hold;
+    else if (name == "linear")
+        method = Method::Linear;
+    else if (name == "cubic")
+        method = Method::Cubic;
+    else
+        return false;
+    return true;
+}
+
+void CommandInterpolator::initialize(size_t num_joints, Method method, double command_period, double control_period)
+{
+    method_ = method;
+    cycles_per_command_ = (control_period > 0.0) ? std::max(1.0, command_period / control_period) : 1.0;
+    step_ = 1.0 / cycles_per_command_;
+    s_ = 1.0;
+
+    latest_.assign(num_joints, 0.0);
+    start_.assign(num_joints, 0.0);
+    start_vel_.assign(num_joints, 0.0);
+    target_vel_.assign(num_joints, 0.0);
+    output_.assign(num_joints, 0.0);
+    prev_output_.assign(num_joints, 0.0);
+}
+
+void CommandInterpolator::reset(const std::vector<irsl_shm_controller::irsl_float_type> &cmd_vec)
+{
+    size_t n = std::min(cmd_vec.size(), latest_.size());
+    std::copy(cmd_vec.begin(), cmd_vec.begin() + n, latest_.begin());
+    std::copy(cmd_vec.begin(), cmd_vec.begin() + n, output_.begin());
+    std::copy(cmd_vec.begin(), cmd_vec.begin() + n, prev_output_.begin());
+    std::fill(start_vel_.begin(), start_vel_.end(), 0.0);
+    std::fill(target_vel_.begin(), target_vel_.end(), 0.0);
+    s_ = 1.0;
+}
+
+void CommandInterpolator::update(
+    const std::vector<irsl_shm_controller::irsl_float_type> &cmd_vec,
+    std::vector<irsl_shm_controller::irsl_float_type> &out_vec)
+{
+    size_t n = latest_.size();
+    if (out_vec.size() != n)
+    {
+        out_vec.resize(n);
+    }
+
+    if (method_ == Method::Hold || cmd_vec.size() < n)
+    {
+        std::copy(cmd_vec.begin(), cmd_vec.begin() + std::min(cmd_vec.size(), n), out_vec.begin());
+        return;
+    }
+
+    // A new command is detected by a change of its value
+    bool updated = false;
+    for (size_t i = 0; i < n; i++)
+    {
+        updated |= (cmd_vec[i] != latest_[i]);
+    }
+
+    if (updated)
+    {
+        // Start from the current output, so the output stays continuous
+        for (size_t i = 0; i < n; i++)
+        {
+            start_vel_[i] = (output_[i] - prev_output_[i]) * cycles_per_command_;
+            target_vel_[i] = cmd_vec[i] - latest_[i];
+            start_[i] = output_[i];
+            latest_[i] = cmd_vec[i];
+        }
+        s_ = 0.0;
+    }
+
+    s_ = std::min(1.0, s_ + step_);
+    const double s = s_;
+
+    if (method_ == Method::Linear)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            out_vec[i] = start_[i] + (latest_[i] - start_[i]) * s;
+        }
+    }
+    else
+    {
+        // Cubic Hermite basis
+        const double s2 = s * s;
+        const double s3 = s2 * s;
+        const double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+        const double h10 = s3 - 2.0 * s2 + s;
+        const double h01 = -2.0 * s3 + 3.0 * s2;
+        const double h11 = s3 - s2;
+        for (size_t i = 0; i < n; i++)
+        {
+            out_vec[i] = h00 * start_[i] + h10 * start_vel_[i] + h01 * latest_[i] + h11 * target_vel_[i];
+        }
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        prev_output_[i] = output_[i];
+        output_[i] = out_vec[i];
+    }
+}
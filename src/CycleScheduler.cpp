@@ -0,0 +1,200 @@
+#include "CycleScheduler.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+    inline void cpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+}
+
+const int64_t WakeHistogram::BUCKET_LIMITS_NS[WakeHistogram::NUM_BUCKETS] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, INT64_MAX};
+
+void WakeHistogram::reset()
+{
+    std::fill(counts, counts + NUM_BUCKETS, 0);
+    samples = 0;
+    max_ns = 0;
+}
+
+void WakeHistogram::add(int64_t latency_ns)
+{
+    int bucket = 0;
+    while (bucket < NUM_BUCKETS - 1 && latency_ns >= BUCKET_LIMITS_NS[bucket])
+    {
+        bucket++;
+    }
+    counts[bucket]++;
+    samples++;
+    max_ns = std::max(max_ns, latency_ns);
+}
+
+int64_t WakeHistogram::quantile(double quantile) const
+{
+    if (samples == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)std::ceil(quantile * samples);
+    uint64_t count = 0;
+    for (int bucket = 0; bucket < NUM_BUCKETS - 1; bucket++)
+    {
+        count += counts[bucket];
+        if (count >= rank)
+        {
+            return std::min(BUCKET_LIMITS_NS[bucket], max_ns);
+        }
+    }
+    return max_ns;
+}
+
+CycleScheduler::CycleScheduler()
+    : period_ns_(0),
+      policy_(OverrunPolicy::CatchUp),
+      spin_guard_ns_(0),
+      free_run_(false),
+      deadline_ns_(0),
+      statistics_{0, 0, 0, 0, 0, 0, 0}
+{
+    wake_histogram_.reset();
+}
+
+bool CycleScheduler::parsePolicy(const std::string &name, OverrunPolicy &policy)
+{
+    if (name == "catch_up")
+        policy = OverrunPolicy::CatchUp;
+    else if (name == "skip")
+        policy = OverrunPolicy::Skip;
+    else if (name == "realign")
+        policy = OverrunPolicy::Realign;
+    else
+        return false;
+    return true;
+}
+
+void CycleScheduler::initialize(int64_t period_ns, OverrunPolicy policy)
+{
+    period_ns_ = period_ns;
+    policy_ = policy;
+}
+
+void CycleScheduler::setSpinGuard(int64_t guard_ns)
+{
+    spin_guard_ns_ = std::max<int64_t>(guard_ns, 0);
+}
+
+void CycleScheduler::setFreeRun(bool free_run)
+{
+    free_run_ = free_run;
+}
+
+void CycleScheduler::start()
+{
+    statistics_ = CycleStatistics{0, 0, 0, 0, 0, 0, 0};
+    wake_histogram_.reset();
+    deadline_ns_ = now() + period_ns_;
+}
+
+bool CycleScheduler::wait()
+{
+    if (free_run_)
+    {
+        statistics_.cycles++;
+        return true;
+    }
+
+    bool on_time = true;
+
+    int64_t current = now();
+    if (current < deadline_ns_)
+    {
+        sleepUntil(deadline_ns_);
+        wake_histogram_.add(now() - deadline_ns_);
+        statistics_.miss_streak = 0;
+    }
+    else
+    {
+        on_time = false;
+        int64_t overrun = current - deadline_ns_;
+        statistics_.overruns++;
+        statistics_.last_overrun_ns = overrun;
+        statistics_.worst_overrun_ns = std::max(statistics_.worst_overrun_ns, overrun);
+        statistics_.miss_streak++;
+        statistics_.max_miss_streak = std::max(statistics_.max_miss_streak, statistics_.miss_streak);
+
+        switch (policy_)
+        {
+        case OverrunPolicy::CatchUp:
+            break;
+        case OverrunPolicy::Skip:
+        {
+            // the late cycle and every deadline passed since are dropped
+            int64_t missed = (period_ns_ > 0) ? overrun / period_ns_ + 1 : 1;
+            deadline_ns_ += missed * period_ns_;
+            statistics_.skipped_cycles += missed;
+            sleepUntil(deadline_ns_);
+            break;
+        }
+        case OverrunPolicy::Realign:
+            deadline_ns_ = current;
+            break;
+        }
+    }
+
+    deadline_ns_ += period_ns_;
+    statistics_.cycles++;
+    return on_time;
+}
+
+const CycleStatistics &CycleScheduler::getStatistics() const
+{
+    return statistics_;
+}
+
+const WakeHistogram &CycleScheduler::getWakeHistogram() const
+{
+    return wake_histogram_;
+}
+
+void CycleScheduler::resetWakeHistogram()
+{
+    wake_histogram_.reset();
+}
+
+int64_t CycleScheduler::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void CycleScheduler::sleepUntil(int64_t deadline_ns) const
+{
+    // sleep until the guard time before the deadline, then spin for the rest
+    int64_t wake_ns = deadline_ns - spin_guard_ns_;
+    struct timespec ts;
+    ts.tv_sec = wake_ns / 1000000000;
+    ts.tv_nsec = wake_ns % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+    {
+    }
+    if (spin_guard_ns_ > 0)
+    {
+        while (now() < deadline_ns)
+        {
+            cpuRelax();
+        }
+    }
+}
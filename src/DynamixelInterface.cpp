@@ -1,7 +1,59 @@
 #include "DynamixelInterface.h"
+#include "RealtimeLogger.h"
+
+#include <chrono>
+#include <map>
+#include <thread>
+
+namespace
+{
+    // Unchanged goals are resent after this many skipped cycles, as sync writes get no status packet
+    const size_t DEFAULT_COMMAND_REFRESH_CYCLES = 10;
+
+    // Status_Return_Level
+    const int32_t STATUS_RETURN_READ = 1; // reply to PING and READ
+    const int32_t STATUS_RETURN_ALL = 2;  // reply to all instructions
+
+    // Return_Delay_Time tried in order (2 [usec] per unit), and sync reads per group for each
+    const std::vector<int32_t> RETURN_DELAY_CANDIDATES = {0, 5, 25, 50, 125, 250};
+    const size_t RETURN_DELAY_PROBES = 20;
+
+    // Baud rate and Baud_Rate value of Protocol 2.0 models, fastest first
+    const std::vector<std::pair<int32_t, uint8_t>> BAUD_RATE_VALUES = {
+        {4500000, 7}, {4000000, 6}, {3000000, 5}, {2000000, 4}, {1000000, 3}, {115200, 2}, {57600, 1}, {9600, 0}};
+    const uint8_t BROADCAST_ID = 0xFE;
+    // Time for the Dynamixels to apply a new Baud_Rate [msec]
+    const int BAUD_RATE_SETTLE_MS = 50;
+
+    // Register values are read unsigned; 2 byte goals (Goal_Current, Goal_PWM) are signed
+    int32_t signExtendGoal(uint32_t data, uint16_t data_length)
+    {
+        return (data_length == 2) ? (int32_t)(int16_t)data : (int32_t)data;
+    }
+
+    // Sign and magnitude velocity (Protocol 1.0 and XL-320): values above this are reverse
+    const int32_t VELOCITY_SIGN_OFFSET = 1023;
+}
 
 DynamixelInterface::DynamixelInterface()
-    : dxl_wb_(std::make_unique<DynamixelWorkbench>())
+    : dxl_wb_(std::make_unique<DynamixelWorkbench>()),
+      use_indirect_address_(true),
+      indirect_feedback_(false),
+      feedback_address_(0),
+      feedback_length_(0),
+      feedback_handler_index_(0),
+      command_item_names_({"Goal_Position", "Goal_Velocity"}),
+      indirect_goal_(false),
+      command_deadband_(0),
+      command_refresh_cycles_(DEFAULT_COMMAND_REFRESH_CYCLES),
+      gain_address_(0),
+      gain_length_(0),
+      gain_handler_index_(0),
+      control_period_(0.0),
+      baud_rate_(0),
+      transaction_overhead_(0.0),
+      tune_status_return_(false),
+      max_baud_rate_(0)
 {
 }
 
@@ -9,6 +61,16 @@ DynamixelInterface::~DynamixelInterface()
 {
 }
 
+void DynamixelInterface::setCommandItems(const std::vector<std::string> &item_names)
+{
+    command_item_names_ = item_names;
+}
+
+void DynamixelInterface::setGainItems(const std::vector<std::string> &item_names)
+{
+    gain_item_names_ = item_names;
+}
+
 bool DynamixelInterface::initialize(YAML::Node &settings)
 {
     // Initialize the interface by setting parameters from settings
@@ -20,13 +82,30 @@ bool DynamixelInterface::initialize(YAML::Node &settings)
     }
 
     // Discover connected Dynamixels
+    const bool escalate = max_baud_rate_ > baud_rate_;
     result = discoverConnectedDynamixels();
+    if (!result && escalate)
+    {
+        // A previous run may have left them at a faster rate
+        result = findBaudRate();
+    }
     if (!result)
     {
         std::cerr << "Error: unable to discover connected Dynamixels" << std::endl;
         return false; // Return immediately on failure
     }
 
+    // Switch to the fastest rate every Dynamixel answers at
+    if (escalate)
+    {
+        result = escalateBaudRate();
+        if (!result)
+        {
+            std::cerr << "Error: Dynamixels do not answer after changing the baud rate" << std::endl;
+            return false; // Return immediately on failure
+        }
+    }
+
     // Initialize settings for the Dynamixels
     result = writeInitialSettings();
     if (!result)
@@ -50,6 +129,17 @@ bool DynamixelInterface::initialize(YAML::Node &settings)
         std::cerr << "Error: unable to initialize SDK handlers" << std::endl;
         return false; // Return immediately on failure
     }
+
+    // Writes are no longer answered from here on
+    if (tune_status_return_)
+    {
+        result = applyStatusReturnLevel();
+        if (!result)
+        {
+            std::cerr << "Error: unable to set Status_Return_Level" << std::endl;
+            return false; // Return immediately on failure
+        }
+    }
     return true;
 }
 
@@ -58,6 +148,47 @@ bool DynamixelInterface::parseParamsFromYAML(YAML::Node &settings)
 
     auto const port_name = settings["port_name"].as<std::string>();
     auto const baud_rate = settings["baud_rate"].as<int32_t>();
+    if (settings["period"])
+    {
+        control_period_ = settings["period"].as<double>();
+    }
+    if (settings["indirect_address"])
+    {
+        use_indirect_address_ = settings["indirect_address"].as<bool>();
+    }
+    if (settings["command_deadband"])
+    {
+        command_deadband_ = settings["command_deadband"].as<int32_t>();
+    }
+    if (settings["command_refresh_cycles"])
+    {
+        command_refresh_cycles_ = settings["command_refresh_cycles"].as<size_t>();
+    }
+    if (settings["transaction_overhead"])
+    {
+        transaction_overhead_ = settings["transaction_overhead"].as<double>();
+    }
+    if (settings["tune_status_return"])
+    {
+        tune_status_return_ = settings["tune_status_return"].as<bool>();
+    }
+    if (settings["max_baud_rate"])
+    {
+        max_baud_rate_ = settings["max_baud_rate"].as<int32_t>();
+    }
+    baud_rate_ = baud_rate;
+
+    aux_items_.clear();
+    for (const auto &aux : settings["auxiliary_items"])
+    {
+        AuxiliaryItem aux_item;
+        aux_item.item_name = aux["name"].as<std::string>();
+        aux_item.rate = aux["rate"].as<double>();
+        aux_item.reads_per_cycle = 0.0;
+        aux_item.credit = 0.0;
+        aux_item.cursor = 0;
+        aux_items_.push_back(aux_item);
+    }
 
     dx_info.clear();
     size_t index = 0;
@@ -66,6 +197,7 @@ bool DynamixelInterface::parseParamsFromYAML(YAML::Node &settings)
     {
         DynamixelInfo info;
         info.comm_group_name = "default";
+        info.torque_constant = 1.0;
         for (auto joint_data = joint.begin(); joint_data != joint.end(); ++joint_data)
         {
             std::string key = joint_data->first.as<std::string>();
@@ -77,6 +209,19 @@ bool DynamixelInterface::parseParamsFromYAML(YAML::Node &settings)
             {
                 info.comm_group_name = joint_data->second.as<std::string>();
             }
+            else if (key == "TorqueConstant")
+            {
+                info.torque_constant = joint_data->second.as<double>();
+            }
+            else if (key == "CommandMode")
+            {
+                auto const mode = joint_data->second.as<std::string>();
+                if (!parseCommandMode(mode, info.command_item))
+                {
+                    std::cerr << "Unknown CommandMode: " << mode << std::endl;
+                    return false;
+                }
+            }
             else if (key == "DynamixelSettings")
             {
                 auto const dx_settings = joint_data->second;
@@ -128,6 +273,31 @@ bool DynamixelInterface::writeInitialSettings()
 {
     const char *log;
 
+    for (const auto &info : dx_info)
+    {
+        // A previous run with tune_status_return leaves writes unanswered until power off,
+        // reads are still answered, so the level is only written back when it was lowered
+        int32_t level = STATUS_RETURN_ALL;
+        if (dxl_wb_->getItemInfo(info.id, "Status_Return_Level") == nullptr ||
+            !dxl_wb_->itemRead(info.id, "Status_Return_Level", &level, &log) ||
+            level >= STATUS_RETURN_ALL)
+        {
+            continue;
+        }
+        // The write itself is not answered, so check it by a read
+        dxl_wb_->itemWrite(info.id, "Status_Return_Level", STATUS_RETURN_ALL, &log);
+        if (!dxl_wb_->itemRead(info.id, "Status_Return_Level", &level, &log) || level != STATUS_RETURN_ALL)
+        {
+            std::cerr << "Failed to restore Status_Return_Level of Dynamixel[ ID : " << (int32_t)info.id << "]" << std::endl;
+            return false;
+        }
+    }
+
+    if (tune_status_return_ && !tuneReturnDelay())
+    {
+        return false;
+    }
+
     for (const auto &info : dx_info)
     {
         // Get the current ID
@@ -151,6 +321,283 @@ bool DynamixelInterface::writeInitialSettings()
     return true;
 }
 
+bool DynamixelInterface::hasSetting(const DynamixelInfo &info, const std::string &item_name)
+{
+    for (const auto &setting : info.dxl_setting)
+    {
+        if (setting.item_name == item_name)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DynamixelInterface::tuneReturnDelay(void)
+{
+    const char *log = nullptr;
+
+    // Return_Delay_Time given in DynamixelSettings is kept
+    std::vector<uint8_t> tuned_ids;
+    for (const auto &info : dx_info)
+    {
+        if (!hasSetting(info, "Return_Delay_Time") && dxl_wb_->getItemInfo(info.id, "Return_Delay_Time") != nullptr)
+        {
+            tuned_ids.push_back(info.id);
+        }
+    }
+    if (tuned_ids.empty())
+    {
+        return true;
+    }
+
+    const ControlItem *probe_item = dxl_wb_->getItemInfo(dx_info.front().id, "Present_Position");
+    if (probe_item == nullptr)
+    {
+        std::cerr << "Failed to get ControlItem: Present_Position" << std::endl;
+        return false;
+    }
+    // Back-to-back status packets of a sync read are the tightest case, Protocol 1.0 is probed by reads
+    uint8_t probe_handler = 0;
+    bool sync_probe = (dxl_wb_->getProtocolVersion() == 2.0f) &&
+                      acquireSyncReadHandler(probe_item->address, probe_item->data_length, probe_handler);
+
+    // Return_Delay_Time of the other joints does not change, so it is read before any probe is timed
+    std::map<uint8_t, int32_t> fixed_delays;
+    for (const auto &info : dx_info)
+    {
+        int32_t delay = 0;
+        if (std::find(tuned_ids.begin(), tuned_ids.end(), info.id) == tuned_ids.end() &&
+            dxl_wb_->itemRead(info.id, "Return_Delay_Time", &delay, &log))
+        {
+            fixed_delays[info.id] = delay;
+        }
+    }
+
+    // Return_Delay_Time is EEPROM
+    for (uint8_t id : tuned_ids)
+    {
+        dxl_wb_->torqueOff(id, &log);
+    }
+
+    for (int32_t candidate : RETURN_DELAY_CANDIDATES)
+    {
+        bool written = true;
+        for (uint8_t id : tuned_ids)
+        {
+            written &= dxl_wb_->itemWrite(id, "Return_Delay_Time", candidate, &log);
+        }
+        if (!written)
+        {
+            std::cerr << "Failed to write Return_Delay_Time " << candidate << std::endl;
+            continue;
+        }
+
+        // Predict the transactions of the probe
+        BusPlanner model;
+        model.setBus(baud_rate_, dxl_wb_->getProtocolVersion());
+        for (const auto &group_pair : comm_group_id_map)
+        {
+            std::vector<int32_t> delays;
+            for (uint8_t id : group_pair.second)
+            {
+                auto it = fixed_delays.find(id);
+                delays.push_back((it != fixed_delays.end()) ? it->second : candidate);
+            }
+            model.addSyncRead(group_pair.first, delays, probe_item->data_length);
+        }
+
+        // Probe every group, only the probe is timed
+        bool dropped = false;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &group_pair : comm_group_id_map)
+        {
+            const std::vector<uint8_t> &comm_group_id = group_pair.second;
+            for (size_t n = 0; n < RETURN_DELAY_PROBES; n++)
+            {
+                if (sync_probe)
+                {
+                    dropped |= !dxl_wb_->syncRead(probe_handler, const_cast<uint8_t *>(comm_group_id.data()), comm_group_id.size(), &log);
+                    continue;
+                }
+                for (uint8_t id : comm_group_id)
+                {
+                    uint32_t data = 0;
+                    dropped |= !dxl_wb_->readRegister(id, probe_item->address, probe_item->data_length, &data, &log);
+                }
+            }
+        }
+        double measured = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / RETURN_DELAY_PROBES;
+
+        std::cout << "Return_Delay_Time " << candidate << " : " << (dropped ? "dropped" : "ok")
+                  << ", " << measured * 1e6 << " [usec] per cycle (predicted " << model.getCycleTime() * 1e6 << " [usec])" << std::endl;
+        if (!dropped)
+        {
+            return true;
+        }
+    }
+
+    std::cerr << "Status packets are dropped with every Return_Delay_Time" << std::endl;
+    return false;
+}
+
+bool DynamixelInterface::applyStatusReturnLevel(void)
+{
+    const char *log = nullptr;
+
+    for (const auto &info : dx_info)
+    {
+        if (hasSetting(info, "Status_Return_Level") || dxl_wb_->getItemInfo(info.id, "Status_Return_Level") == nullptr)
+        {
+            continue;
+        }
+
+        // The write itself may not be answered, so check it by a read, which is still answered
+        dxl_wb_->itemWrite(info.id, "Status_Return_Level", STATUS_RETURN_READ, &log);
+        int32_t level = -1;
+        if (!dxl_wb_->itemRead(info.id, "Status_Return_Level", &level, &log) || level != STATUS_RETURN_READ)
+        {
+            std::cerr << "Failed to set Status_Return_Level of Dynamixel[ ID : " << (int32_t)info.id << "]" << std::endl;
+            return false;
+        }
+    }
+    std::cout << "Status_Return_Level : " << STATUS_RETURN_READ << " (reply to PING and READ only)" << std::endl;
+
+    return true;
+}
+
+bool DynamixelInterface::pingAll(void)
+{
+    const char *log = nullptr;
+
+    for (const auto &info : dx_info)
+    {
+        uint16_t model_number = 0;
+        if (!dxl_wb_->ping(info.id, &model_number, &log))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DynamixelInterface::setPortBaudRate(int32_t baud_rate)
+{
+    const char *log = nullptr;
+
+    if (!dxl_wb_->setBaudrate(baud_rate, &log))
+    {
+        return false;
+    }
+    baud_rate_ = baud_rate;
+    return true;
+}
+
+bool DynamixelInterface::findBaudRate(void)
+{
+    const int32_t configured_rate = baud_rate_;
+
+    for (const auto &rate : BAUD_RATE_VALUES)
+    {
+        if (rate.first > max_baud_rate_ || rate.first == configured_rate)
+        {
+            continue;
+        }
+        if (setPortBaudRate(rate.first) && pingAll())
+        {
+            std::cout << "Dynamixels found at baud rate " << rate.first << std::endl;
+            return true;
+        }
+    }
+    setPortBaudRate(configured_rate);
+    return false;
+}
+
+bool DynamixelInterface::switchBaudRate(int32_t baud_rate, uint8_t value, uint16_t baud_rate_address, uint16_t torque_enable_address)
+{
+    const char *log = nullptr;
+
+    // Baud_Rate is EEPROM, so the torque is disabled first (writeInitialSettings enables it again)
+    uint8_t torque_enable = 0;
+    bool result = dxl_wb_->writeRegister(BROADCAST_ID, torque_enable_address, 1, &torque_enable, &log);
+    result = result && dxl_wb_->writeRegister(BROADCAST_ID, baud_rate_address, 1, &value, &log);
+    if (!result)
+    {
+        std::cerr << ((log != nullptr) ? log : "") << std::endl;
+        return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(BAUD_RATE_SETTLE_MS));
+
+    // Every Dynamixel must answer at the new rate, twice in a row
+    return setPortBaudRate(baud_rate) && pingAll() && pingAll();
+}
+
+bool DynamixelInterface::escalateBaudRate(void)
+{
+    if (dxl_wb_->getProtocolVersion() != 2.0f)
+    {
+        std::cerr << "max_baud_rate is ignored: the baud rate can only be changed on Protocol 2.0" << std::endl;
+        return true;
+    }
+
+    // Broadcast writes need the same Baud_Rate and Torque_Enable addresses on every model
+    const ControlItem *baud_rate_item = dxl_wb_->getItemInfo(dx_info.front().id, "Baud_Rate");
+    const ControlItem *torque_enable_item = dxl_wb_->getItemInfo(dx_info.front().id, "Torque_Enable");
+    for (const auto &info : dx_info)
+    {
+        const ControlItem *baud_item = dxl_wb_->getItemInfo(info.id, "Baud_Rate");
+        const ControlItem *torque_item = dxl_wb_->getItemInfo(info.id, "Torque_Enable");
+        if (baud_rate_item == nullptr || torque_enable_item == nullptr || baud_item == nullptr || torque_item == nullptr ||
+            baud_item->address != baud_rate_item->address || torque_item->address != torque_enable_item->address)
+        {
+            std::cerr << "max_baud_rate is ignored: Baud_Rate is not shared by the connected models" << std::endl;
+            return true;
+        }
+    }
+
+    const int32_t initial_rate = baud_rate_;
+    auto initial = std::find_if(BAUD_RATE_VALUES.begin(), BAUD_RATE_VALUES.end(),
+                                [initial_rate](const std::pair<int32_t, uint8_t> &rate) { return rate.first == initial_rate; });
+    if (initial == BAUD_RATE_VALUES.end())
+    {
+        std::cerr << "max_baud_rate is ignored: baud rate " << initial_rate << " can not be restored by Baud_Rate" << std::endl;
+        return true;
+    }
+
+    for (const auto &rate : BAUD_RATE_VALUES)
+    {
+        if (rate.first > max_baud_rate_)
+        {
+            continue;
+        }
+        if (rate.first <= initial_rate)
+        {
+            break;
+        }
+        // Rates the adapter does not take are skipped before touching the Dynamixels
+        if (!setPortBaudRate(rate.first))
+        {
+            continue;
+        }
+        setPortBaudRate(initial_rate);
+
+        if (switchBaudRate(rate.first, rate.second, baud_rate_item->address, torque_enable_item->address))
+        {
+            std::cout << "Baud rate : " << initial_rate << " -> " << rate.first << std::endl;
+            return true;
+        }
+        std::cerr << "Some Dynamixels do not answer at baud rate " << rate.first << ", falling back to " << initial_rate << std::endl;
+
+        // Those which switched take the broadcast at the new rate, the others already are at the initial rate
+        if (!switchBaudRate(initial->first, initial->second, baud_rate_item->address, torque_enable_item->address))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool DynamixelInterface::discoverConnectedDynamixels(void)
 {
     bool result = false;
@@ -215,270 +662,1355 @@ bool DynamixelInterface::initializeControlItems(void)
         control_items_[key] = item;
     }
 
-    return true;
-}
-
-bool DynamixelInterface::initSDKHandlers(void)
-{
-    bool result = false;
-    const char *log = NULL;
-
-    result = dxl_wb_->addSyncWriteHandler(control_items_["Goal_Position"]->address, control_items_["Goal_Position"]->data_length, &log);
-    if (result == false)
+    // Feedback fields (the first three are always read)
+    feedback_fields_.clear();
+    for (const auto &key : {"Present_Position", "Present_Velocity", "Present_Current"})
     {
-        std::cerr << log << std::endl;
-        return result;
+        const ControlItem *item = control_items_[key];
+        feedback_fields_.push_back(FeedbackField{key, item, item->address, item->data_length, {}});
     }
-    else
+    // Optional fields are only read when they can be packed by indirect addressing
+    for (const auto &key : {"Present_Temperature", "Hardware_Error_Status"})
+    {
+        const ControlItem *item = dxl_wb_->getItemInfo(sample_id, key);
+        if (item != nullptr)
+        {
+            feedback_fields_.push_back(FeedbackField{key, item, item->address, item->data_length, std::vector<int32_t>(dx_info.size(), 0)});
+        }
+    }
+
+    // Position is linear on each side of the zero position and velocity is linear
+    // (sign and magnitude on some models), so the model units are resolved once
+    // and the conversions never touch the workbench from the publisher thread
+    position_zero_.resize(dx_info.size());
+    position_scale_.resize(dx_info.size());
+    position_scale_negative_.resize(dx_info.size());
+    velocity_scale_.resize(dx_info.size());
+    velocity_sign_offset_.resize(dx_info.size());
+    for (size_t i = 0; i < dx_info.size(); i++)
     {
-        std::cout << log << std::endl;
+        uint8_t id = dx_info[i].id;
+        position_zero_[i] = dxl_wb_->convertRadian2Value(id, 0.0f);
+        position_scale_[i] = dxl_wb_->convertValue2Radian(id, position_zero_[i] + 1);
+        position_scale_negative_[i] = -dxl_wb_->convertValue2Radian(id, position_zero_[i] - 1);
+        velocity_scale_[i] = dxl_wb_->convertValue2Velocity(id, 1);
+        // Sign and magnitude models report a reverse velocity above this offset
+        velocity_sign_offset_[i] = (dxl_wb_->convertValue2Velocity(id, VELOCITY_SIGN_OFFSET + 1) < 0.0f) ? VELOCITY_SIGN_OFFSET : 0;
     }
 
-    result = dxl_wb_->addSyncWriteHandler(control_items_["Goal_Velocity"]->address, control_items_["Goal_Velocity"]->data_length, &log);
-    if (result == false)
+    // The conversion is linear, so resolve the model specific unit once
+    current_scale_.resize(dx_info.size());
+    for (size_t i = 0; i < dx_info.size(); i++)
     {
-        std::cerr << log << std::endl;
-        return result;
+        current_scale_[i] = dxl_wb_->convertValue2Current(dx_info[i].id, (int16_t)1);
     }
-    else
+    torque_scale_.resize(dx_info.size());
+    torque_scale_inv_.resize(dx_info.size());
+    for (size_t i = 0; i < dx_info.size(); i++)
     {
-        std::cout << log << std::endl;
+        torque_scale_[i] = current_scale_[i] * dx_info[i].torque_constant;
+        torque_scale_inv_[i] = (torque_scale_[i] != 0.0) ? 1.0 / torque_scale_[i] : 0.0;
     }
 
-    if (dxl_wb_->getProtocolVersion() == 2.0f)
+    // Current commands are clamped to Current_Limit
+    current_limit_.assign(dx_info.size(), INT16_MAX);
+    for (size_t i = 0; i < dx_info.size(); i++)
     {
-        uint16_t start_address = std::min(control_items_["Present_Position"]->address, control_items_["Present_Current"]->address);
-
-        /*
-          As some models have an empty space between Present_Velocity and Present Current, read_length is modified as below.
-        */
-        // uint16_t read_length = control_items_["Present_Position"]->data_length + control_items_["Present_Velocity"]->data_length + control_items_["Present_Current"]->data_length;
-        uint16_t read_length = control_items_["Present_Position"]->data_length + control_items_["Present_Velocity"]->data_length + control_items_["Present_Current"]->data_length + 2;
-
-        result = dxl_wb_->addSyncReadHandler(start_address,
-                                             read_length,
-                                             &log);
-        if (result == false)
+        int32_t current_limit = 0;
+        if (dxl_wb_->getItemInfo(dx_info[i].id, "Current_Limit") != nullptr &&
+            dxl_wb_->itemRead(dx_info[i].id, "Current_Limit", &current_limit, &log))
         {
-            std::cerr << log << std::endl;
-            return result;
+            current_limit_[i] = current_limit;
         }
     }
 
-    return result;
+    return initializeAuxiliaryItems();
 }
 
-size_t DynamixelInterface::getNumberOfDynamixels()
+bool DynamixelInterface::initializeAuxiliaryItems(void)
 {
-    return dx_info.size();
-}
+    size_t id_vec_size = dx_info.size();
 
-void DynamixelInterface::convertPosition(
-    const std::vector<int32_t> &pos_vec,
-    std::vector<irsl_shm_controller::irsl_float_type> &pos_float_vec)
-{
-    if (pos_vec.size() != pos_float_vec.size())
-    {
-        pos_float_vec.resize(pos_vec.size());
-    }
-    for (size_t i = 0; i < dx_info.size(); i++)
+    for (auto &aux : aux_items_)
     {
-        irsl_shm_controller::irsl_float_type angle = dxl_wb_->convertValue2Radian(dx_info[i].id, pos_vec[i]);
-        pos_float_vec[i] = angle;
-    }
+        aux.items.assign(id_vec_size, nullptr);
+        aux.values.assign(id_vec_size, 0);
+
+        size_t num_supported = 0;
+        for (size_t i = 0; i < id_vec_size; i++)
+        {
+            // Addresses differ between models, so look up the item for each joint
+            aux.items[i] = dxl_wb_->getItemInfo(dx_info[i].id, aux.item_name.c_str());
+            if (aux.items[i] == nullptr)
+            {
+                std::cerr << "Auxiliary item[" << aux.item_name << "] is not available on Dynamixel[ ID : " << (int32_t)dx_info[i].id << "]" << std::endl;
+            }
+            else
+            {
+                num_supported++;
+            }
+        }
+        if (num_supported == 0)
+        {
+            std::cerr << "Failed to get ControlItem: " << aux.item_name << std::endl;
+            return false;
+        }
+
+        // A joint can not be read more than once per cycle
+        double reads_per_cycle = id_vec_size * aux.rate * control_period_;
+        if (reads_per_cycle > id_vec_size || control_period_ <= 0.0)
+        {
+            reads_per_cycle = id_vec_size;
+        }
+        aux.reads_per_cycle = reads_per_cycle;
+        aux.credit = 0.0;
+        aux.cursor = 0;
+
+        std::cout << "Auxiliary item : " << aux.item_name << ", rate : " << aux.rate << " [Hz], reads per cycle : " << aux.reads_per_cycle << std::endl;
+    }
+
+    return true;
+}
+
+bool DynamixelInterface::initSDKHandlers(void)
+{
+    bool result = false;
+
+    if (dxl_wb_->getProtocolVersion() == 2.0f)
+    {
+        indirect_feedback_ = use_indirect_address_ && initializeIndirectFeedback();
+        if (!indirect_feedback_)
+        {
+            // Only Present_Position..Present_Current are read without indirect addressing
+            feedback_fields_.resize(3);
+
+            /*
+              As some models have an empty space between Present_Velocity and Present Current,
+              the window spans from the lowest to the highest address of the fields.
+            */
+            uint16_t start_address = 0xFFFF;
+            uint16_t end_address = 0;
+            for (auto &field : feedback_fields_)
+            {
+                field.read_address = field.item->address;
+                start_address = std::min<uint16_t>(start_address, field.item->address);
+                end_address = std::max<uint16_t>(end_address, field.item->address + field.data_length);
+            }
+            feedback_address_ = start_address;
+            feedback_length_ = end_address - start_address;
+        }
+
+        result = acquireSyncReadHandler(feedback_address_, feedback_length_, feedback_handler_index_);
+        if (result == false)
+        {
+            return result;
+        }
+        std::cout << "Feedback read window : address " << feedback_address_ << ", length " << feedback_length_
+                  << (indirect_feedback_ ? " (indirect)" : "") << std::endl;
+
+        // Packed items are refreshed every cycle, so they need no polling
+        for (auto &aux : aux_items_)
+        {
+            for (size_t f = 3; f < feedback_fields_.size(); f++)
+            {
+                if (feedback_fields_[f].item_name == aux.item_name)
+                {
+                    aux.reads_per_cycle = 0.0;
+                }
+            }
+        }
+    }
+
+    // Goal fields are packed after the feedback block
+    result = initializeGoalFields();
+    if (result)
+    {
+        result = initializeGainFields();
+    }
+
+    return result;
+}
+
+bool DynamixelInterface::initializeGoalFields(void)
+{
+    bool result = false;
+    const char *log = NULL;
+
+    uint8_t sample_id = dx_info.front().id;
+
+    goal_fields_.clear();
+    for (const auto &name : command_item_names_)
+    {
+        auto it = control_items_.find(name);
+        const ControlItem *item = (it != control_items_.end()) ? it->second : dxl_wb_->getItemInfo(sample_id, name.c_str());
+        if (item == nullptr)
+        {
+            std::cerr << "Failed to get ControlItem: " << name << std::endl;
+            return false;
+        }
+        goal_fields_.push_back(GoalField{name, item, 0, std::vector<int32_t>(dx_info.size(), 0), std::vector<int32_t>(dx_info.size(), 0)});
+    }
+    if (goal_fields_.empty())
+    {
+        return true;
+    }
+
+    // 4-byte fields first (the SyncWrite handler sends 4 bytes for each value, so only the last field may be shorter)
+    std::stable_sort(goal_fields_.begin(), goal_fields_.end(),
+                     [](const GoalField &a, const GoalField &b)
+                     { return a.item->data_length > b.item->data_length; });
+
+    // With mixed modes each packet carries a single item, so nothing is gained by packing
+    bool mixed_mode = resolveJointCommandItems();
+
+    indirect_goal_ = !mixed_mode && (dxl_wb_->getProtocolVersion() == 2.0f) && use_indirect_address_ && initializeIndirectGoal();
+    if (!indirect_goal_)
+    {
+        for (auto &field : goal_fields_)
+        {
+            result = acquireSyncWriteHandler(field.item->address, field.item->data_length, field.handler_index);
+            if (result == false)
+            {
+                return result;
+            }
+        }
+    }
+
+    // Start from the values held by the Dynamixels, so that resending an item that is not updated is harmless
+    for (auto &field : goal_fields_)
+    {
+        for (size_t i = 0; i < dx_info.size(); i++)
+        {
+            uint32_t data = 0;
+            if (dxl_wb_->readRegister(dx_info[i].id, field.item->address, field.item->data_length, &data, &log))
+            {
+                field.values[i] = signExtendGoal(data, field.item->data_length);
+            }
+        }
+        field.written = field.values;
+    }
+
+    // One packet per (group, mode)
+    goal_partitions_.clear();
+    for (const auto &group_pair : comm_group_id_map)
+    {
+        const std::vector<uint8_t> &comm_group_id = group_pair.second;
+
+        if (indirect_goal_)
+        {
+            GoalPartition partition{{}, {}, 0, goal_fields_.size(), goal_fields_.front().handler_index, 0};
+            for (uint8_t id : comm_group_id)
+            {
+                partition.ids.push_back(id);
+                partition.index.push_back(dx_info_index_map[id]);
+            }
+            goal_partitions_.push_back(partition);
+            continue;
+        }
+
+        for (size_t f = 0; f < goal_fields_.size(); f++)
+        {
+            GoalPartition partition{{}, {}, f, 1, goal_fields_[f].handler_index, 0};
+            for (uint8_t id : comm_group_id)
+            {
+                size_t idx = dx_info_index_map[id];
+                // Items other than the mode items (e.g. Profile_Velocity) are written to every joint
+                if (!isModeItem(goal_fields_[f].item_name) || dx_info[idx].command_item == goal_fields_[f].item_name)
+                {
+                    partition.ids.push_back(id);
+                    partition.index.push_back(idx);
+                }
+            }
+            if (!partition.ids.empty())
+            {
+                goal_partitions_.push_back(partition);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool DynamixelInterface::isModeItem(const std::string &item_name)
+{
+    return item_name == "Goal_Position" || item_name == "Goal_Velocity" || item_name == "Goal_Current";
+}
+
+bool DynamixelInterface::parseCommandMode(const std::string &mode, std::string &item_name)
+{
+    if (mode == "Position")
+        item_name = "Goal_Position";
+    else if (mode == "Velocity")
+        item_name = "Goal_Velocity";
+    else if (mode == "Current")
+        item_name = "Goal_Current";
+    else
+        return false;
+    return true;
+}
+
+std::string DynamixelInterface::commandItemOfOperatingMode(int32_t operating_mode)
+{
+    switch (operating_mode)
+    {
+    case 0: // Current Control
+        return "Goal_Current";
+    case 1: // Velocity Control
+        return "Goal_Velocity";
+    case 3: // Position Control
+    case 4: // Extended Position Control
+    case 5: // Current-based Position Control
+        return "Goal_Position";
+    default:
+        return "";
+    }
+}
+
+bool DynamixelInterface::resolveJointCommandItems(void)
+{
+    bool mixed_mode = false;
+
+    for (auto &info : dx_info)
+    {
+        if (info.command_item.empty())
+        {
+            // Derive from Operating_Mode
+            for (const auto &setting : info.dxl_setting)
+            {
+                if (setting.item_name == "Operating_Mode")
+                {
+                    info.command_item = commandItemOfOperatingMode(setting.value);
+                }
+            }
+        }
+
+        bool commanded = false;
+        for (const auto &field : goal_fields_)
+        {
+            commanded |= (field.item_name == info.command_item);
+        }
+        if (!commanded)
+        {
+            if (!info.command_item.empty())
+            {
+                std::cerr << info.command_item << " of Dynamixel[ ID : " << (int32_t)info.id << "] is not commanded, "
+                          << command_item_names_.front() << " is used" << std::endl;
+            }
+            info.command_item = command_item_names_.front();
+        }
+
+        mixed_mode |= (info.command_item != dx_info.front().command_item);
+    }
+
+    // Mode items which no joint uses are not written
+    goal_fields_.erase(
+        std::remove_if(goal_fields_.begin(), goal_fields_.end(),
+                       [this](const GoalField &field)
+                       {
+                           if (!isModeItem(field.item_name))
+                           {
+                               return false;
+                           }
+                           for (const auto &info : dx_info)
+                           {
+                               if (info.command_item == field.item_name)
+                               {
+                                   return false;
+                               }
+                           }
+                           return true;
+                       }),
+        goal_fields_.end());
+
+    return mixed_mode;
+}
+
+bool DynamixelInterface::initializeGainFields(void)
+{
+    const char *log = nullptr;
+
+    gain_fields_.clear();
+    if (gain_item_names_.empty())
+    {
+        return true;
+    }
+
+    uint8_t sample_id = dx_info.front().id;
+    uint16_t start_address = 0xFFFF;
+    uint16_t end_address = 0;
+    for (const auto &name : gain_item_names_)
+    {
+        const ControlItem *item = dxl_wb_->getItemInfo(sample_id, name.c_str());
+        bool available = (item != nullptr);
+        for (const auto &info : dx_info)
+        {
+            const ControlItem *joint_item = dxl_wb_->getItemInfo(info.id, name.c_str());
+            if (joint_item == nullptr || item == nullptr || joint_item->address != item->address)
+            {
+                available = false;
+            }
+        }
+        if (!available)
+        {
+            std::cerr << "Gain item[" << name << "] is not available on all Dynamixels, gains are not written" << std::endl;
+            gain_fields_.clear();
+            return true;
+        }
+
+        gain_fields_.push_back(GainField{name, item, 0});
+        start_address = std::min<uint16_t>(start_address, item->address);
+        end_address = std::max<uint16_t>(end_address, item->address + item->data_length);
+    }
+    gain_address_ = start_address;
+    gain_length_ = end_address - start_address;
+    for (auto &field : gain_fields_)
+    {
+        field.offset = field.item->address - gain_address_;
+    }
+
+    // Read the whole window, so that bytes which are not commanded are written back unchanged
+    gain_written_.assign(dx_info.size() * gain_length_, 0);
+    for (size_t i = 0; i < dx_info.size(); i++)
+    {
+        uint16_t offset = 0;
+        while (offset < gain_length_)
+        {
+            uint16_t remain = gain_length_ - offset;
+            uint16_t length = (remain >= 4) ? 4 : (remain >= 2) ? 2 : 1;
+            uint32_t data = 0;
+            if (!dxl_wb_->readRegister(dx_info[i].id, gain_address_ + offset, length, &data, &log))
+            {
+                std::cerr << log << std::endl;
+                std::cerr << "Failed to read gains from Dynamixel[ ID : " << (int32_t)dx_info[i].id << "]" << std::endl;
+                return false;
+            }
+            for (uint16_t b = 0; b < length; b++)
+            {
+                gain_written_[i * gain_length_ + offset + b] = (data >> (8 * b)) & 0xFF;
+            }
+            offset += length;
+        }
+    }
+    gain_pending_ = gain_written_;
+
+    std::cout << "Gain write window : address " << gain_address_ << ", length " << gain_length_ << std::endl;
+
+    return acquireSyncWriteHandler(gain_address_, gain_length_, gain_handler_index_);
+}
+
+bool DynamixelInterface::initializeIndirectGoal(void)
+{
+    bool result = false;
+
+    size_t num_short_fields = 0;
+    uint16_t goal_length = 0;
+    for (const auto &field : goal_fields_)
+    {
+        if (field.item->data_length < 4)
+        {
+            num_short_fields++;
+        }
+        goal_length += field.item->data_length;
+    }
+    if (num_short_fields > 1)
+    {
+        std::cerr << "Goal items can not be packed: more than one item shorter than 4 bytes" << std::endl;
+        return false;
+    }
+
+    uint8_t sample_id = dx_info.front().id;
+
+    // All Dynamixels must share the same control table layout
+    for (const auto &info : dx_info)
+    {
+        for (const auto &field : goal_fields_)
+        {
+            const ControlItem *item = dxl_wb_->getItemInfo(info.id, field.item_name.c_str());
+            if (item == nullptr || item->address != field.item->address)
+            {
+                return false;
+            }
+        }
+    }
+
+    const std::vector<std::pair<std::string, std::string>> banks = {
+        {"Indirect_Address_1", "Indirect_Data_1"},
+        {"Indirect_Address_29", "Indirect_Data_29"}};
+
+    for (size_t b = 0; b < banks.size(); b++)
+    {
+        const ControlItem *indirect_address = dxl_wb_->getItemInfo(sample_id, banks[b].first.c_str());
+        const ControlItem *indirect_data = dxl_wb_->getItemInfo(sample_id, banks[b].second.c_str());
+        if (indirect_address == nullptr || indirect_data == nullptr || indirect_data->address <= indirect_address->address)
+        {
+            continue;
+        }
+
+        size_t num_slots = (indirect_data->address - indirect_address->address) / 2;
+        size_t used_slots = (b == 0 && indirect_feedback_) ? feedback_length_ : 0;
+        if (used_slots + goal_length > num_slots)
+        {
+            continue;
+        }
+
+        std::vector<uint16_t> addresses;
+        for (const auto &field : goal_fields_)
+        {
+            for (uint16_t i = 0; i < field.item->data_length; i++)
+            {
+                addresses.push_back(field.item->address + i);
+            }
+        }
+        if (!writeIndirectAddressTable(indirect_address->address + 2 * used_slots, addresses))
+        {
+            return false;
+        }
+
+        uint16_t goal_address = indirect_data->address + used_slots;
+        uint8_t handler_index = 0;
+        result = acquireSyncWriteHandler(goal_address, goal_length, handler_index);
+        if (result == false)
+        {
+            return false;
+        }
+        for (auto &field : goal_fields_)
+        {
+            field.handler_index = handler_index;
+        }
+        std::cout << "Goal write window : address " << goal_address << ", length " << goal_length << " (indirect)" << std::endl;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool DynamixelInterface::acquireSyncWriteHandler(
+    uint16_t address,
+    uint16_t length,
+    uint8_t &handler_index)
+{
+    const char *log = nullptr;
+
+    auto it = sync_write_handlers_.find(std::make_pair(address, length));
+    if (it != sync_write_handlers_.end())
+    {
+        handler_index = it->second;
+        return true;
+    }
+
+    if (!dxl_wb_->addSyncWriteHandler(address, length, &log))
+    {
+        std::cerr << log << std::endl;
+        std::cerr << "Failed to add SyncWrite handler: address " << address << ", length " << length << std::endl;
+        return false;
+    }
+    std::cout << log << std::endl;
+
+    handler_index = dxl_wb_->getTheNumberOfSyncWriteHandler() - 1;
+    sync_write_handlers_[std::make_pair(address, length)] = handler_index;
+    return true;
+}
+
+bool DynamixelInterface::acquireSyncReadHandler(
+    uint16_t address,
+    uint16_t length,
+    uint8_t &handler_index)
+{
+    const char *log = nullptr;
+
+    auto it = sync_read_handlers_.find(std::make_pair(address, length));
+    if (it != sync_read_handlers_.end())
+    {
+        handler_index = it->second;
+        return true;
+    }
+
+    if (!dxl_wb_->addSyncReadHandler(address, length, &log))
+    {
+        std::cerr << log << std::endl;
+        std::cerr << "Failed to add SyncRead handler: address " << address << ", length " << length << std::endl;
+        return false;
+    }
+
+    handler_index = dxl_wb_->getTheNumberOfSyncReadHandler() - 1;
+    sync_read_handlers_[std::make_pair(address, length)] = handler_index;
+    return true;
+}
+
+bool DynamixelInterface::writeIndirectAddressTable(
+    uint16_t table_address,
+    const std::vector<uint16_t> &addresses)
+{
+    const char *log = nullptr;
+
+    std::vector<uint8_t> address_table;
+    for (uint16_t address : addresses)
+    {
+        address_table.push_back(DXL_LOBYTE(address));
+        address_table.push_back(DXL_HIBYTE(address));
+    }
+
+    for (const auto &info : dx_info)
+    {
+        // Indirect Address can only be written while torque is disabled
+        int32_t torque_enable = 0;
+        dxl_wb_->itemRead(info.id, "Torque_Enable", &torque_enable, &log);
+        if (torque_enable)
+        {
+            dxl_wb_->torqueOff(info.id, &log);
+        }
+
+        bool result = dxl_wb_->writeRegister(info.id, table_address, address_table.size(), address_table.data(), &log);
+
+        if (torque_enable)
+        {
+            dxl_wb_->torqueOn(info.id, &log);
+        }
+        if (result == false)
+        {
+            std::cerr << log << std::endl;
+            std::cerr << "Failed to write Indirect Address to Dynamixel[ ID : " << (int32_t)info.id << "]" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DynamixelInterface::initializeIndirectFeedback(void)
+{
+    uint8_t sample_id = dx_info.front().id;
+    const ControlItem *indirect_address = dxl_wb_->getItemInfo(sample_id, "Indirect_Address_1");
+    const ControlItem *indirect_data = dxl_wb_->getItemInfo(sample_id, "Indirect_Data_1");
+    if (indirect_address == nullptr || indirect_data == nullptr || indirect_data->address <= indirect_address->address)
+    {
+        return false;
+    }
+
+    // The Indirect Address table (2 bytes per slot) is followed by Indirect Data (1 byte per slot)
+    size_t num_slots = (indirect_data->address - indirect_address->address) / 2;
+
+    // All Dynamixels must share the same control table layout
+    for (const auto &info : dx_info)
+    {
+        for (const auto &field : feedback_fields_)
+        {
+            const ControlItem *item = dxl_wb_->getItemInfo(info.id, field.item_name.c_str());
+            if (item == nullptr || item->address != field.item->address)
+            {
+                return false;
+            }
+        }
+        const ControlItem *address_item = dxl_wb_->getItemInfo(info.id, "Indirect_Address_1");
+        if (address_item == nullptr || address_item->address != indirect_address->address)
+        {
+            return false;
+        }
+    }
+
+    // One Indirect Address entry for each byte of the fields
+    std::vector<uint16_t> addresses;
+    uint16_t offset = 0;
+    for (auto &field : feedback_fields_)
+    {
+        for (uint16_t b = 0; b < field.data_length; b++)
+        {
+            addresses.push_back(field.item->address + b);
+        }
+        field.read_address = indirect_data->address + offset;
+        offset += field.data_length;
+    }
+    if (offset > num_slots)
+    {
+        std::cerr << "Not enough Indirect Data for feedback: " << offset << " > " << num_slots << std::endl;
+        return false;
+    }
+
+    if (!writeIndirectAddressTable(indirect_address->address, addresses))
+    {
+        return false;
+    }
+
+    feedback_address_ = indirect_data->address;
+    feedback_length_ = offset;
+
+    return true;
+}
+
+bool DynamixelInterface::isIndirectFeedback() const
+{
+    return indirect_feedback_;
+}
+
+size_t DynamixelInterface::getNumberOfDynamixels()
+{
+    return dx_info.size();
+}
+
+bool DynamixelInterface::pollAuxiliaryItems()
+{
+    bool result = true;
+    const char *log = nullptr;
+
+    for (auto &aux : aux_items_)
+    {
+        aux.credit += aux.reads_per_cycle;
+        while (aux.credit >= 1.0)
+        {
+            aux.credit -= 1.0;
+
+            size_t idx = aux.cursor;
+            aux.cursor = (aux.cursor + 1) % aux.values.size();
+
+            const ControlItem *item = aux.items[idx];
+            if (item == nullptr)
+            {
+                continue;
+            }
+
+            uint32_t data = 0;
+            if (!dxl_wb_->readRegister(dx_info[idx].id, item->address, item->data_length, &data, &log))
+            {
+                RT_LOG_ERROR("readRegister %s failed %s", aux.item_name.c_str(), (log != nullptr) ? log : "");
+                result = false;
+                continue;
+            }
+            aux.values[idx] = (int32_t)data;
+        }
+    }
+
+    return result;
+}
+
+bool DynamixelInterface::getAuxiliaryItem(
+    const std::string &item_name,
+    std::vector<int32_t> &value_vec) const
+{
+    for (size_t f = 3; f < feedback_fields_.size(); f++)
+    {
+        if (feedback_fields_[f].item_name == item_name)
+        {
+            value_vec = feedback_fields_[f].values;
+            return true;
+        }
+    }
+    for (const auto &aux : aux_items_)
+    {
+        if (aux.item_name == item_name)
+        {
+            value_vec = aux.values;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DynamixelInterface::convertTemperature(
+    const std::vector<int32_t> &temp_vec,
+    std::vector<irsl_shm_controller::irsl_float_type> &temp_float_vec)
+{
+    if (temp_vec.size() != temp_float_vec.size())
+    {
+        temp_float_vec.resize(temp_vec.size());
+    }
+    for (size_t i = 0; i < temp_vec.size(); i++)
+    {
+        // Present_Temperature is 1 [degC] per unit on all models
+        temp_float_vec[i] = (irsl_shm_controller::irsl_float_type)temp_vec[i];
+    }
+}
+
+void DynamixelInterface::convertPosition(
+    const std::vector<int32_t> &pos_vec,
+    std::vector<irsl_shm_controller::irsl_float_type> &pos_float_vec)
+{
+    if (pos_vec.size() != pos_float_vec.size())
+    {
+        pos_float_vec.resize(pos_vec.size());
+    }
+    for (size_t i = 0; i < dx_info.size(); i++)
+    {
+        int32_t value = pos_vec[i] - position_zero_[i];
+        irsl_shm_controller::irsl_float_type angle = value * ((value > 0) ? position_scale_[i] : position_scale_negative_[i]);
+        pos_float_vec[i] = angle;
+    }
+}
+
+void DynamixelInterface::convertVelocity(
+    const std::vector<int32_t> &vel_vec,
+    std::vector<irsl_shm_controller::irsl_float_type> &vel_float_vec)
+{
+    if (vel_vec.size() != vel_float_vec.size())
+    {
+        vel_float_vec.resize(vel_vec.size());
+    }
+    for (size_t i = 0; i < dx_info.size(); i++)
+    {
+        int32_t value = vel_vec[i];
+        if (velocity_sign_offset_[i] != 0 && value > velocity_sign_offset_[i])
+        {
+            value = velocity_sign_offset_[i] - value;
+        }
+        irsl_shm_controller::irsl_float_type vel = value * velocity_scale_[i];
+        vel_float_vec[i] = vel;
+    }
+}
+
+void DynamixelInterface::convertCurrent(
+    const std::vector<int32_t> &cur_vec,
+    std::vector<irsl_shm_controller::irsl_float_type> &cur_float_vec)
+{
+    if (cur_vec.size() != cur_float_vec.size())
+    {
+        cur_float_vec.resize(cur_vec.size());
+    }
+    for (size_t i = 0; i < dx_info.size(); i++)
+    {
+        irsl_shm_controller::irsl_float_type cur = current_scale_[i] * (int16_t)cur_vec[i];
+        cur_float_vec[i] = cur;
+    }
+}
+
+void DynamixelInterface::convertTorque(
+    const std::vector<int32_t> &cur_vec,
+    std::vector<irsl_shm_controller::irsl_float_type> &torque_float_vec)
+{
+    if (cur_vec.size() != torque_float_vec.size())
+    {
+        torque_float_vec.resize(cur_vec.size());
+    }
+    for (size_t i = 0; i < dx_info.size(); i++)
+    {
+        irsl_shm_controller::irsl_float_type tor = torque_scale_[i] * (int16_t)cur_vec[i];
+        torque_float_vec[i] = tor;
+    }
+}
+
+void DynamixelInterface::convertCurrentAndTorque(
+    const std::vector<int32_t> &cur_vec,
+    std::vector<irsl_shm_controller::irsl_float_type> &cur_float_vec,
+    std::vector<irsl_shm_controller::irsl_float_type> &torque_float_vec)
+{
+    if (cur_vec.size() != cur_float_vec.size())
+    {
+        cur_float_vec.resize(cur_vec.size());
+    }
+    if (cur_vec.size() != torque_float_vec.size())
+    {
+        torque_float_vec.resize(cur_vec.size());
+    }
+    for (size_t i = 0; i < dx_info.size(); i++)
+    {
+        irsl_shm_controller::irsl_float_type cur = current_scale_[i] * (int16_t)cur_vec[i];
+        cur_float_vec[i] = cur;
+        torque_float_vec[i] = cur * dx_info[i].torque_constant;
+    }
+}
+
+void DynamixelInterface::convertPositionCmd(
+    const std::vector<irsl_shm_controller::irsl_float_type> &pos_float_vec,
+    std::vector<int32_t> &dynamixel_position)
+{
+    size_t id_vec_size = dx_info.size();
+    dynamixel_position.resize(id_vec_size);
+    for (size_t i = 0; i < id_vec_size; i++)
+    {
+        irsl_shm_controller::irsl_float_type scale = (pos_float_vec[i] > 0) ? position_scale_[i] : position_scale_negative_[i];
+        dynamixel_position[i] = (scale != 0.0) ? (int32_t)(pos_float_vec[i] / scale + position_zero_[i]) : position_zero_[i];
+    }
 }
 
-void DynamixelInterface::convertVelocity(
-    const std::vector<int32_t> &vel_vec,
-    std::vector<irsl_shm_controller::irsl_float_type> &vel_float_vec)
+bool DynamixelInterface::writeBySyncHandler(
+    GoalPartition &partition)
 {
-    if (vel_vec.size() != vel_float_vec.size())
+    bool result = false;
+    const char *log = nullptr;
+
+    // Skip the packet when no goal moved beyond the deadband
+    bool changed = false;
+    for (size_t idx : partition.index)
     {
-        vel_float_vec.resize(vel_vec.size());
+        for (size_t f = partition.first_field; f < partition.first_field + partition.num_fields; f++)
+        {
+            const GoalField &field = goal_fields_[f];
+            if (std::abs((int64_t)field.values[idx] - field.written[idx]) > command_deadband_)
+            {
+                changed = true;
+            }
+        }
     }
-    for (size_t i = 0; i < dx_info.size(); i++)
+    bool refresh = (command_refresh_cycles_ > 0) && (partition.skipped_cycles + 1 >= command_refresh_cycles_);
+    if (!changed && !refresh)
     {
-        irsl_shm_controller::irsl_float_type vel = dxl_wb_->convertValue2Velocity(dx_info[i].id, vel_vec[i]);
-        vel_float_vec[i] = vel;
+        partition.skipped_cycles++;
+        return true;
     }
-}
 
-void DynamixelInterface::convertCurrent(
-    const std::vector<int32_t> &cur_vec,
-    std::vector<irsl_shm_controller::irsl_float_type> &cur_float_vec)
-{
-    if (cur_vec.size() != cur_float_vec.size())
+    goal_tmp_.clear();
+    for (size_t idx : partition.index)
     {
-        cur_float_vec.resize(cur_vec.size());
+        for (size_t f = partition.first_field; f < partition.first_field + partition.num_fields; f++)
+        {
+            goal_tmp_.push_back(goal_fields_[f].values[idx]);
+        }
     }
-    for (size_t i = 0; i < dx_info.size(); i++)
+
+    result = dxl_wb_->syncWrite(
+        partition.handler_index,
+        const_cast<uint8_t *>(partition.ids.data()), partition.ids.size(),
+        goal_tmp_.data(), partition.num_fields, &log);
+    if (!result)
     {
-        irsl_shm_controller::irsl_float_type cur = dxl_wb_->convertValue2Current(dx_info[i].id, cur_vec[i]);
-        cur_float_vec[i] = cur;
+        RT_LOG_ERROR("%s", (log != nullptr) ? log : "syncWrite failed");
+        return false;
+    }
+
+    for (size_t idx : partition.index)
+    {
+        for (size_t f = partition.first_field; f < partition.first_field + partition.num_fields; f++)
+        {
+            goal_fields_[f].written[idx] = goal_fields_[f].values[idx];
+        }
     }
+    partition.skipped_cycles = 0;
+
+    return true;
 }
 
-void DynamixelInterface::convertTorque(
-    const std::vector<int32_t> &cur_vec,
-    std::vector<irsl_shm_controller::irsl_float_type> &torque_float_vec)
+bool DynamixelInterface::setGoal(
+    const std::string &item_name,
+    const std::vector<int32_t> &value_vec)
 {
-    if (cur_vec.size() != torque_float_vec.size())
+    for (auto &field : goal_fields_)
     {
-        torque_float_vec.resize(cur_vec.size());
+        if (field.item_name == item_name)
+        {
+            std::copy(value_vec.begin(), value_vec.begin() + std::min(value_vec.size(), field.values.size()), field.values.begin());
+            return true;
+        }
     }
-    for (size_t i = 0; i < dx_info.size(); i++)
+    return false;
+}
+
+bool DynamixelInterface::writeGoals()
+{
+    for (auto &partition : goal_partitions_)
     {
-        irsl_shm_controller::irsl_float_type tor = dxl_wb_->convertValue2Current(dx_info[i].id, cur_vec[i]);
-        torque_float_vec[i] = tor;
+        if (!writeBySyncHandler(partition))
+        {
+            return false;
+        }
     }
+    return true;
 }
 
-void DynamixelInterface::convertPositionCmd(
-    const std::vector<irsl_shm_controller::irsl_float_type> &pos_float_vec,
-    std::vector<int32_t> &dynamixel_position)
+void DynamixelInterface::convertGainCmd(
+    const std::vector<irsl_shm_controller::irsl_float_type> &gain_float_vec,
+    std::vector<int32_t> &dynamixel_gain)
 {
     size_t id_vec_size = dx_info.size();
-    dynamixel_position.resize(id_vec_size);
+    dynamixel_gain.resize(id_vec_size);
     for (size_t i = 0; i < id_vec_size; i++)
     {
-        dynamixel_position[i] = dxl_wb_->convertRadian2Value(dx_info[i].id, pos_float_vec[i]);
+        dynamixel_gain[i] = std::max<int32_t>(0, (int32_t)std::lround(gain_float_vec[i]));
     }
 }
 
-bool DynamixelInterface::writeBySyncHandler(
-    uint8_t handler_index,
-    const std::vector<int32_t> &value_vector)
+bool DynamixelInterface::getGain(
+    const std::string &item_name,
+    std::vector<irsl_shm_controller::irsl_float_type> &gain_float_vec) const
+{
+    for (const auto &field : gain_fields_)
+    {
+        if (field.item_name == item_name)
+        {
+            gain_float_vec.resize(dx_info.size());
+            for (size_t i = 0; i < dx_info.size(); i++)
+            {
+                uint32_t value = 0;
+                for (uint16_t b = 0; b < field.item->data_length; b++)
+                {
+                    value |= (uint32_t)gain_written_[i * gain_length_ + field.offset + b] << (8 * b);
+                }
+                gain_float_vec[i] = (irsl_shm_controller::irsl_float_type)value;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DynamixelInterface::setGain(
+    const std::string &item_name,
+    const std::vector<int32_t> &value_vec)
+{
+    for (const auto &field : gain_fields_)
+    {
+        if (field.item_name == item_name)
+        {
+            size_t n = std::min(value_vec.size(), dx_info.size());
+            for (size_t i = 0; i < n; i++)
+            {
+                uint32_t value = (uint32_t)value_vec[i];
+                for (uint16_t b = 0; b < field.item->data_length; b++)
+                {
+                    gain_pending_[i * gain_length_ + field.offset + b] = (value >> (8 * b)) & 0xFF;
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DynamixelInterface::writeGains()
 {
     bool result = false;
     const char *log = nullptr;
 
-    std::vector<int32_t> value_tmp;
+    if (gain_fields_.empty())
+    {
+        return true;
+    }
+
+    // The window is sent as 4-byte values, the last one may be partially used
+    size_t num_values = (gain_length_ + 3) / 4;
 
     for (const auto &group_pair : comm_group_id_map)
     {
         const std::vector<uint8_t> &comm_group_id = group_pair.second;
 
-        value_tmp.clear();
+        bool changed = false;
         for (uint8_t id : comm_group_id)
         {
-            auto it = dx_info_index_map.find(id);
-            if (it != dx_info_index_map.end())
+            size_t idx = dx_info_index_map[id];
+            if (std::memcmp(&gain_pending_[idx * gain_length_], &gain_written_[idx * gain_length_], gain_length_) != 0)
             {
-                value_tmp.push_back(value_vector[it->second]);
+                changed = true;
+                break;
             }
-            else
+        }
+        if (!changed)
+        {
+            continue;
+        }
+
+        gain_tmp_.clear();
+        for (uint8_t id : comm_group_id)
+        {
+            size_t idx = dx_info_index_map[id];
+            for (size_t v = 0; v < num_values; v++)
             {
-                std::cerr << "ID not found in dx_info_index_map: " << static_cast<int>(id) << std::endl;
-                return false;
+                uint32_t value = 0;
+                for (size_t b = 0; b < 4 && v * 4 + b < gain_length_; b++)
+                {
+                    value |= (uint32_t)gain_pending_[idx * gain_length_ + v * 4 + b] << (8 * b);
+                }
+                gain_tmp_.push_back((int32_t)value);
             }
         }
 
         result = dxl_wb_->syncWrite(
-            handler_index,
+            gain_handler_index_,
             const_cast<uint8_t *>(comm_group_id.data()), comm_group_id.size(),
-            value_tmp.data(), 1, &log);
+            gain_tmp_.data(), num_values, &log);
         if (!result)
         {
-            std::cerr << log << std::endl;
+            RT_LOG_ERROR("%s", (log != nullptr) ? log : "syncWrite failed");
+            return false;
+        }
+
+        for (uint8_t id : comm_group_id)
+        {
+            size_t idx = dx_info_index_map[id];
+            std::memcpy(&gain_written_[idx * gain_length_], &gain_pending_[idx * gain_length_], gain_length_);
+        }
+    }
+
+    return true;
+}
+
+bool DynamixelInterface::planBus(BusPlanner &planner)
+{
+    bool result = true;
+    const char *log = nullptr;
+
+    planner.setBus(baud_rate_, dxl_wb_->getProtocolVersion());
+    planner.setTransactionOverhead(transaction_overhead_);
+
+    std::vector<int32_t> return_delay_time(dx_info.size(), 0);
+    for (size_t i = 0; i < dx_info.size(); i++)
+    {
+        if (!dxl_wb_->itemRead(dx_info[i].id, "Return_Delay_Time", &return_delay_time[i], &log))
+        {
+            std::cerr << "Failed to read Return_Delay_Time of Dynamixel[ ID : " << (int32_t)dx_info[i].id << "]" << std::endl;
+            result = false;
+        }
+    }
+
+    for (const auto &group_pair : comm_group_id_map)
+    {
+        std::vector<int32_t> group_delay;
+        for (uint8_t id : group_pair.second)
+        {
+            group_delay.push_back(return_delay_time[dx_info_index_map[id]]);
+        }
+        planner.addSyncRead("sync read [" + group_pair.first + "]", group_delay, feedback_length_);
+    }
+
+    for (const auto &partition : goal_partitions_)
+    {
+        uint16_t data_length = 0;
+        std::string items;
+        for (size_t f = partition.first_field; f < partition.first_field + partition.num_fields; f++)
+        {
+            data_length += goal_fields_[f].item->data_length;
+            items += " " + goal_fields_[f].item_name;
+        }
+        const std::string &group = dx_info[partition.index.front()].comm_group_name;
+        planner.addSyncWrite("sync write [" + group + "]" + items, partition.ids.size(), data_length);
+    }
+
+    // Auxiliary reads go round-robin over the joints, so their average delay is used
+    double average_delay = 0.0;
+    for (int32_t delay : return_delay_time)
+    {
+        average_delay += delay;
+    }
+    average_delay /= std::max<size_t>(1, return_delay_time.size());
+    for (const auto &aux : aux_items_)
+    {
+        auto it = std::find_if(aux.items.begin(), aux.items.end(), [](const ControlItem *item) { return item != nullptr; });
+        if (it != aux.items.end())
+        {
+            planner.addRead("read " + aux.item_name, (int32_t)std::lround(average_delay), (*it)->data_length, aux.reads_per_cycle);
+        }
+    }
+
+    return result;
+}
+
+namespace
+{
+    // Lengths in the control table of the X series (estimateBusPlan only)
+    uint16_t estimatedItemLength(const std::string &item_name)
+    {
+        static const std::map<std::string, uint16_t> lengths = {
+            {"Goal_Current", 2},
+            {"Goal_PWM", 2},
+            {"Present_Temperature", 1},
+            {"Present_Input_Voltage", 2},
+            {"Present_PWM", 2},
+            {"Hardware_Error_Status", 1},
+            {"Moving", 1},
+            {"Moving_Status", 1},
+        };
+        auto it = lengths.find(item_name);
+        return (it != lengths.end()) ? it->second : 4;
+    }
+}
+
+bool DynamixelInterface::estimateBusPlan(
+    const YAML::Node &settings,
+    const std::vector<std::string> &command_items,
+    BusPlanner &planner)
+{
+    if (!settings["baud_rate"] || !settings["joint"] || command_items.empty())
+    {
+        std::cerr << "baud_rate and joint are required for the bus plan" << std::endl;
+        return false;
+    }
+
+    // Factory default of Return_Delay_Time
+    const int32_t default_return_delay_time = 250;
+    // Present_Current..Present_Position, and Present_Temperature, Hardware_Error_Status packed after them
+    const uint16_t direct_feedback_length = 10;
+    const uint16_t indirect_feedback_length = 12;
+
+    // With max_baud_rate, the rate expected after escalateBaudRate()
+    int32_t baud_rate = settings["baud_rate"].as<int32_t>();
+    if (settings["max_baud_rate"])
+    {
+        for (const auto &rate : BAUD_RATE_VALUES)
+        {
+            if (rate.first <= settings["max_baud_rate"].as<int32_t>())
+            {
+                baud_rate = std::max(baud_rate, rate.first);
+                break;
+            }
+        }
+    }
+    planner.setBus(baud_rate, 2.0f);
+    if (settings["transaction_overhead"])
+    {
+        planner.setTransactionOverhead(settings["transaction_overhead"].as<double>());
+    }
+    bool indirect = !settings["indirect_address"] || settings["indirect_address"].as<bool>();
+    double period = settings["period"] ? settings["period"].as<double>() : 0.0;
+
+    // Return_Delay_Time and goal item of each joint for each group
+    std::map<std::string, std::vector<std::pair<int32_t, std::string>>> groups;
+    std::set<std::string> used_items;
+    double average_delay = 0.0;
+    size_t num_joints = 0;
+    for (const auto &joint : settings["joint"])
+    {
+        std::string group = joint["CommunicationGroupName"] ? joint["CommunicationGroupName"].as<std::string>() : "default";
+        std::string command_item;
+        int32_t return_delay_time = default_return_delay_time;
+        if (joint["CommandMode"] && !parseCommandMode(joint["CommandMode"].as<std::string>(), command_item))
+        {
+            std::cerr << "Unknown CommandMode: " << joint["CommandMode"].as<std::string>() << std::endl;
             return false;
         }
+        for (const auto &dx_setting : joint["DynamixelSettings"])
+        {
+            auto const name = dx_setting.first.as<std::string>();
+            if (name == "Return_Delay_Time")
+            {
+                return_delay_time = dx_setting.second.as<int32_t>();
+            }
+            else if (name == "Operating_Mode" && !joint["CommandMode"])
+            {
+                command_item = commandItemOfOperatingMode(dx_setting.second.as<int32_t>());
+            }
+        }
+        if (std::find(command_items.begin(), command_items.end(), command_item) == command_items.end())
+        {
+            command_item = command_items.front();
+        }
+        groups[group].push_back({return_delay_time, command_item});
+        used_items.insert(command_item);
+        average_delay += return_delay_time;
+        num_joints++;
+    }
+    average_delay /= std::max<size_t>(1, num_joints);
+
+    // Mode items which no joint uses are not written
+    std::vector<std::string> goal_items;
+    for (const auto &name : command_items)
+    {
+        if (!isModeItem(name) || used_items.count(name) > 0)
+        {
+            goal_items.push_back(name);
+        }
+    }
+    bool indirect_goal = indirect && used_items.size() == 1;
+
+    for (const auto &group_pair : groups)
+    {
+        std::vector<int32_t> group_delay;
+        for (const auto &joint : group_pair.second)
+        {
+            group_delay.push_back(joint.first);
+        }
+        planner.addSyncRead("sync read [" + group_pair.first + "]", group_delay,
+                            indirect ? indirect_feedback_length : direct_feedback_length);
+
+        if (indirect_goal)
+        {
+            uint16_t data_length = 0;
+            std::string items;
+            for (const auto &name : goal_items)
+            {
+                data_length += estimatedItemLength(name);
+                items += " " + name;
+            }
+            planner.addSyncWrite("sync write [" + group_pair.first + "]" + items, group_pair.second.size(), data_length);
+            continue;
+        }
+        for (const auto &name : goal_items)
+        {
+            size_t num_ids = 0;
+            for (const auto &joint : group_pair.second)
+            {
+                if (!isModeItem(name) || joint.second == name)
+                {
+                    num_ids++;
+                }
+            }
+            planner.addSyncWrite("sync write [" + group_pair.first + "] " + name, num_ids, estimatedItemLength(name));
+        }
+    }
+
+    for (const auto &aux : settings["auxiliary_items"])
+    {
+        auto const name = aux["name"].as<std::string>();
+        if (indirect && (name == "Present_Temperature" || name == "Hardware_Error_Status"))
+        {
+            // refreshed by the sync read
+            continue;
+        }
+        double reads_per_cycle = num_joints * aux["rate"].as<double>() * period;
+        if (reads_per_cycle > num_joints || period <= 0.0)
+        {
+            reads_per_cycle = num_joints;
+        }
+        planner.addRead("read " + name, (int32_t)std::lround(average_delay), estimatedItemLength(name), reads_per_cycle);
+    }
+
+    return true;
+}
+
+void DynamixelInterface::convertTorqueCmd(
+    const std::vector<irsl_shm_controller::irsl_float_type> &torque_float_vec,
+    std::vector<int32_t> &dynamixel_current)
+{
+    size_t id_vec_size = dx_info.size();
+    dynamixel_current.resize(id_vec_size);
+    for (size_t i = 0; i < id_vec_size; i++)
+    {
+        // Clamped before rounding, which is undefined out of range; a NaN or infinite command is zero current
+        double value = torque_float_vec[i] * torque_scale_inv_[i];
+        if (!std::isfinite(value))
+        {
+            value = 0.0;
+        }
+        value = std::min(std::max(value, -(double)current_limit_[i]), (double)current_limit_[i]);
+        dynamixel_current[i] = (int32_t)std::lround(value);
     }
+}
 
+bool DynamixelInterface::writeGoalItem(
+    const std::string &item_name,
+    const std::vector<int32_t> &value_vec)
+{
+    if (!setGoal(item_name, value_vec))
+    {
+        return false;
+    }
+    for (auto &partition : goal_partitions_)
+    {
+        for (size_t f = partition.first_field; f < partition.first_field + partition.num_fields; f++)
+        {
+            if (goal_fields_[f].item_name == item_name)
+            {
+                if (!writeBySyncHandler(partition))
+                {
+                    return false;
+                }
+                break;
+            }
+        }
+    }
     return true;
 }
 
+bool DynamixelInterface::writeCurrent(const std::vector<int32_t> &dynamixel_current)
+{
+    return writeGoalItem("Goal_Current", dynamixel_current);
+}
 
 bool DynamixelInterface::writePosition(const std::vector<int32_t> &dynamixel_position)
 {
-    return writeBySyncHandler(SYNC_WRITE_HANDLER_FOR_GOAL_POSITION, dynamixel_position);
+    return writeGoalItem("Goal_Position", dynamixel_position);
 }
 
 bool DynamixelInterface::writeVelocity(const std::vector<int32_t> &dynamixel_velocity)
 {
-    return writeBySyncHandler(SYNC_WRITE_HANDLER_FOR_GOAL_VELOCITY, dynamixel_velocity);
-}
-
-
-// bool DynamixelInterface::writePosition(
-//     const std::vector<int32_t> &dynamixel_position)
-// {
-//     bool result = false;
-//     const char *log = NULL;
-
-//     std::vector<int32_t> dynamixel_position_tmp;
-//     for (const auto &group_pair : comm_group_id_map)
-//     {
-//         const std::string &group_name = group_pair.first;
-//         const std::vector<uint8_t> &comm_group_id = group_pair.second;
-
-//         dynamixel_position_tmp.clear();
-//         for (uint8_t id : comm_group_id)
-//         {
-//             auto it = dx_info_index_map.find(id);
-//             if (it != dx_info_index_map.end())
-//             {
-//                 dynamixel_position_tmp.push_back(dynamixel_position[it->second]);
-//             }
-//             else
-//             {
-//                 std::cerr << "ID not found in dx_info_index_map: " << static_cast<int>(id) << std::endl;
-//                 return false;
-//             }
-//         }
-
-//         result = dxl_wb_->syncWrite(
-//             SYNC_WRITE_HANDLER_FOR_GOAL_POSITION,
-//             const_cast<uint8_t *>(comm_group_id.data()), comm_group_id.size(),
-//             dynamixel_position_tmp.data(), 1, &log);
-//         if (result == false)
-//         {
-//             std::cerr << log << std::endl;
-//             return result;
-//         }
-//     }
-//     return result;
-// }
-
-// bool DynamixelInterface::writeVelocity(
-//     const std::vector<int32_t> &dynamixel_velocity)
-// {
-//     bool result = false;
-//     const char *log = NULL;
-
-//     std::vector<int32_t> dynamixel_velocity_tmp;
-//     for (const auto &group_pair : comm_group_id_map)
-//     {
-//         const std::string &group_name = group_pair.first;
-//         const std::vector<uint8_t> &comm_group_id = group_pair.second;
-
-//         dynamixel_velocity_tmp.clear();
-//         for (uint8_t id : comm_group_id)
-//         {
-//             auto it = dx_info_index_map.find(id);
-//             if (it != dx_info_index_map.end())
-//             {
-//                 dynamixel_velocity_tmp.push_back(dynamixel_velocity[it->second]);
-//             }
-//             else
-//             {
-//                 std::cerr << "ID not found in dx_info_index_map: " << static_cast<int>(id) << std::endl;
-//                 return false;
-//             }
-//         }
-
-//         result = dxl_wb_->syncWrite(
-//             SYNC_WRITE_HANDLER_FOR_GOAL_VELOCITY,
-//             const_cast<uint8_t *>(comm_group_id.data()), comm_group_id.size(),
-//             dynamixel_velocity_tmp.data(), 1, &log);
-//         if (result == false)
-//         {
-//             std::cerr << log << std::endl;
-//             return result;
-//         }
-//     }
-//     return result;
-// }
-
+    return writeGoalItem("Goal_Velocity", dynamixel_velocity);
+}
 
 void DynamixelInterface::convertVelocityCmd(
     const std::vector<irsl_shm_controller::irsl_float_type> &vel_float_vec,
@@ -488,17 +2020,29 @@ void DynamixelInterface::convertVelocityCmd(
     dynamixel_velocity.resize(id_vec_size);
     for (size_t i = 0; i < id_vec_size; i++)
     {
-        dynamixel_velocity[i] = dxl_wb_->convertVelocity2Value(dx_info[i].id, vel_float_vec[i]);
+        if (velocity_scale_[i] == 0.0)
+        {
+            dynamixel_velocity[i] = 0;
+        }
+        else if (velocity_sign_offset_[i] != 0 && vel_float_vec[i] < 0)
+        {
+            dynamixel_velocity[i] = (int32_t)(-vel_float_vec[i] / velocity_scale_[i]) + velocity_sign_offset_[i];
+        }
+        else
+        {
+            dynamixel_velocity[i] = (int32_t)(vel_float_vec[i] / velocity_scale_[i]);
+        }
     }
 }
 
 
-void DynamixelInterface::getDynamixelCurrentStatus(
+bool DynamixelInterface::getDynamixelCurrentStatus(
     std::vector<int32_t> &pos_vec,
     std::vector<int32_t> &vel_vec,
     std::vector<int32_t> &cur_vec)
 {
     bool result = false;
+    bool status = true;
     const char *log = NULL;
 
     size_t id_vec_size = dx_info.size();
@@ -518,75 +2062,58 @@ void DynamixelInterface::getDynamixelCurrentStatus(
 
     for (const auto &group_pair : comm_group_id_map)
     {
-        const std::string &group_name = group_pair.first;
         const std::vector<uint8_t> &comm_group_id = group_pair.second;
 
         size_t comm_group_id_size = comm_group_id.size();
-        std::vector<int32_t> pos_vec_tmp(comm_group_id.size());
-        std::vector<int32_t> vel_vec_tmp(comm_group_id.size());
-        std::vector<int32_t> cur_vec_tmp(comm_group_id.size());
-
-        result = dxl_wb_->syncRead(
-            SYNC_READ_HANDLER_FOR_PRESENT_POSITION_VELOCITY_CURRENT,
-            const_cast<uint8_t *>(comm_group_id.data()), comm_group_id_size,
-            &log);
-        if (!result)
+        if (feedback_tmp_.size() < comm_group_id_size)
         {
-            std::cerr << "syncRead failed " << log << std::endl;
-            return;
+            feedback_tmp_.resize(comm_group_id_size);
         }
 
-        result = dxl_wb_->getSyncReadData(
-            SYNC_READ_HANDLER_FOR_PRESENT_POSITION_VELOCITY_CURRENT,
+        result = dxl_wb_->syncRead(
+            feedback_handler_index_,
             const_cast<uint8_t *>(comm_group_id.data()), comm_group_id_size,
-            control_items_["Present_Position"]->address,
-            control_items_["Present_Position"]->data_length,
-            pos_vec_tmp.data(),
             &log);
         if (!result)
         {
-            std::cerr << "getSyncReadData position failed " << log << std::endl;
-        }
-
-        result = dxl_wb_->getSyncReadData(
-            SYNC_READ_HANDLER_FOR_PRESENT_POSITION_VELOCITY_CURRENT,
-            const_cast<uint8_t *>(comm_group_id.data()), comm_group_id_size,
-            control_items_["Present_Velocity"]->address,
-            control_items_["Present_Velocity"]->data_length,
-            vel_vec_tmp.data(),
-            &log);
-        if (result == false)
-        {
-            std::cerr << "getSyncReadData velocity failed " << log << std::endl;
-        }
-
-        result = dxl_wb_->getSyncReadData(
-            SYNC_READ_HANDLER_FOR_PRESENT_POSITION_VELOCITY_CURRENT,
-            const_cast<uint8_t *>(comm_group_id.data()), comm_group_id_size,
-            control_items_["Present_Current"]->address,
-            control_items_["Present_Current"]->data_length,
-            cur_vec_tmp.data(),
-            &log);
-        if (result == false)
-        {
-            std::cerr << "getSyncReadData current failed " << log << std::endl;
+            RT_LOG_ERROR("syncRead failed %s", (log != nullptr) ? log : "");
+            return false;
         }
 
-        for (size_t j = 0; j < comm_group_id_size; ++j)
+        for (size_t f = 0; f < feedback_fields_.size(); f++)
         {
-            uint8_t id = comm_group_id[j];
-            auto it = dx_info_index_map.find(id);
-            if (it != dx_info_index_map.end())
+            FeedbackField &field = feedback_fields_[f];
+            std::vector<int32_t> &out_vec = (f == 0) ? pos_vec : (f == 1) ? vel_vec : (f == 2) ? cur_vec : field.values;
+
+            result = dxl_wb_->getSyncReadData(
+                feedback_handler_index_,
+                const_cast<uint8_t *>(comm_group_id.data()), comm_group_id_size,
+                field.read_address,
+                field.data_length,
+                feedback_tmp_.data(),
+                &log);
+            if (!result)
             {
-                size_t idx = it->second;
-                pos_vec[idx] = pos_vec_tmp[j];
-                vel_vec[idx] = vel_vec_tmp[j];
-                cur_vec[idx] = cur_vec_tmp[j];
+                RT_LOG_ERROR("getSyncReadData %s failed %s", field.item_name.c_str(), (log != nullptr) ? log : "");
+                status = false;
+                continue;
             }
-            else
+
+            for (size_t j = 0; j < comm_group_id_size; ++j)
             {
-                std::cerr << "Unknown ID in dx_info_index_map: " << static_cast<int>(id) << std::endl;
+                uint8_t id = comm_group_id[j];
+                auto it = dx_info_index_map.find(id);
+                if (it != dx_info_index_map.end())
+                {
+                    out_vec[it->second] = feedback_tmp_[j];
+                }
+                else
+                {
+                    RT_LOG_ERROR("Unknown ID in dx_info_index_map: %d", static_cast<int>(id));
+                }
             }
         }
     }
+
+    return status;
 }
@@ -0,0 +1,291 @@
+#include "FlightRecorder.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+static_assert(sizeof(FlightRecorderHeader) == 64, "FlightRecorderHeader must be 64 bytes");
+static_assert(sizeof(FlightRecord) == 32, "FlightRecord must be 32 bytes");
+
+static constexpr size_t FLIGHT_RECORD_DOUBLE_ARRAYS = 6;
+static constexpr size_t FLIGHT_RECORD_INT32_ARRAYS = 11;
+
+static size_t flightRecordSize(size_t num_joints)
+{
+    size_t size = sizeof(FlightRecord) +
+                  num_joints * (FLIGHT_RECORD_DOUBLE_ARRAYS * sizeof(double) + FLIGHT_RECORD_INT32_ARRAYS * sizeof(int32_t));
+    return (size + 7) & ~(size_t)7;
+}
+
+template <typename T, typename U>
+static T *copyArray(T *dst, const std::vector<U> &src, size_t n)
+{
+    size_t m = std::min(n, src.size());
+    std::copy_n(src.begin(), m, dst);
+    std::fill(dst + m, dst + n, T());
+    return dst + n;
+}
+
+FlightRecorder::FlightRecorder()
+    : addr_(nullptr),
+      size_(0),
+      num_joints_(0),
+      header_(nullptr),
+      records_(nullptr)
+{
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    close();
+}
+
+bool FlightRecorder::create(const std::string &path, size_t num_joints, size_t capacity, double period)
+{
+    close();
+    if (capacity == 0)
+    {
+        std::cerr << "Flight recorder capacity must be positive" << std::endl;
+        return false;
+    }
+
+    size_t record_size = flightRecordSize(num_joints);
+    size_ = sizeof(FlightRecorderHeader) + capacity * record_size;
+
+    int fd = ::open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "open failed: " << path << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, size_) != 0)
+    {
+        std::cerr << "ftruncate failed: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    if (!map(fd, true))
+    {
+        std::cerr << "mmap failed: " << path << std::endl;
+        return false;
+    }
+
+    // Allocate every page now and keep them resident, so recording does not
+    // wait for the disk. The kernel may still write-protect a page while it is
+    // written back, which costs a minor fault on the next record.
+    std::memset(addr_, 0, size_);
+    if (mlock(addr_, size_) != 0)
+    {
+        std::cerr << "mlock failed: " << std::strerror(errno) << " (pages of " << path
+                  << " may be evicted, raise RLIMIT_MEMLOCK)" << std::endl;
+    }
+    header_ = new (addr_) FlightRecorderHeader();
+    header_->version = FLIGHT_RECORDER_VERSION;
+    header_->num_joints = num_joints;
+    header_->capacity = capacity;
+    header_->record_size = record_size;
+    header_->period = period;
+    header_->write_count.store(0, std::memory_order_relaxed);
+    header_->last_frame_tag.store(0, std::memory_order_relaxed);
+    header_->magic = FLIGHT_RECORDER_MAGIC;
+    num_joints_ = num_joints;
+    records_ = static_cast<uint8_t *>(addr_) + sizeof(FlightRecorderHeader);
+
+    return true;
+}
+
+bool FlightRecorder::open(const std::string &path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "open failed: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FlightRecorderHeader))
+    {
+        std::cerr << "Not a flight recorder file: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    size_ = st.st_size;
+    if (!map(fd, false))
+    {
+        std::cerr << "mmap failed: " << path << std::endl;
+        return false;
+    }
+
+    header_ = static_cast<FlightRecorderHeader *>(addr_);
+    if (header_->magic != FLIGHT_RECORDER_MAGIC || header_->version != FLIGHT_RECORDER_VERSION ||
+        header_->record_size != flightRecordSize(header_->num_joints) ||
+        size_ < sizeof(FlightRecorderHeader) + (size_t)header_->capacity * header_->record_size)
+    {
+        std::cerr << "Flight recorder header mismatch: " << path << std::endl;
+        close();
+        return false;
+    }
+    num_joints_ = header_->num_joints;
+    records_ = static_cast<uint8_t *>(addr_) + sizeof(FlightRecorderHeader);
+
+    return true;
+}
+
+bool FlightRecorder::map(int fd, bool writable)
+{
+    int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    addr_ = mmap(nullptr, size_, prot, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr_ == MAP_FAILED)
+    {
+        addr_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void FlightRecorder::close()
+{
+    if (addr_ != nullptr)
+    {
+        munmap(addr_, size_);
+        addr_ = nullptr;
+        header_ = nullptr;
+        records_ = nullptr;
+    }
+}
+
+bool FlightRecorder::isOpen() const
+{
+    return addr_ != nullptr;
+}
+
+FlightRecord *FlightRecorder::recordAt(uint64_t frame) const
+{
+    return reinterpret_cast<FlightRecord *>(records_ + (frame % header_->capacity) * header_->record_size);
+}
+
+void FlightRecorder::record(uint64_t frame,
+                            const StateFrame &state,
+                            const std::vector<irsl_shm_controller::irsl_float_type> &position,
+                            const std::vector<irsl_shm_controller::irsl_float_type> &velocity,
+                            const std::vector<irsl_shm_controller::irsl_float_type> &torque,
+                            const CommandFrame &command,
+                            const std::vector<irsl_shm_controller::irsl_float_type> &command_position,
+                            const std::vector<irsl_shm_controller::irsl_float_type> &command_velocity,
+                            const std::vector<irsl_shm_controller::irsl_float_type> &command_torque)
+{
+    FlightRecord *rec = recordAt(frame);
+    size_t n = num_joints_;
+
+    // Invalidate the slot while it is rewritten
+    rec->frame_tag.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    rec->cycle = state.cycle;
+    rec->timestamp_ns = state.timestamp_ns;
+    rec->flags = state.flags;
+
+    double *d = reinterpret_cast<double *>(rec + 1);
+    d = copyArray(d, position, n);
+    d = copyArray(d, velocity, n);
+    d = copyArray(d, torque, n);
+    d = copyArray(d, command_position, n);
+    d = copyArray(d, command_velocity, n);
+    d = copyArray(d, command_torque, n);
+
+    int32_t *i = reinterpret_cast<int32_t *>(d);
+    i = copyArray(i, state.position, n);
+    i = copyArray(i, state.velocity, n);
+    i = copyArray(i, state.current, n);
+    i = copyArray(i, state.temperature, n);
+    i = copyArray(i, command.position, n);
+    i = copyArray(i, command.velocity, n);
+    i = copyArray(i, command.current, n);
+    i = copyArray(i, state.hardware_error, n);
+    i = copyArray(i, command.position_p_gain, n);
+    i = copyArray(i, command.position_d_gain, n);
+    copyArray(i, command.velocity_p_gain, n);
+
+    rec->frame_tag.store(frame + 1, std::memory_order_release);
+    header_->write_count.store(header_->write_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    header_->last_frame_tag.store(frame + 1, std::memory_order_release);
+}
+
+bool FlightRecorder::getRecord(uint64_t frame, FlightRecordView &view) const
+{
+    const FlightRecord *slot = recordAt(frame);
+    if (slot->frame_tag.load(std::memory_order_acquire) != frame + 1)
+    {
+        return false;
+    }
+    // Copy the slot, and drop the copy if the writer invalidated it meanwhile
+    view.storage.resize(header_->record_size);
+    std::memcpy(view.storage.data(), static_cast<const void *>(slot), header_->record_size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->frame_tag.load(std::memory_order_relaxed) != frame + 1)
+    {
+        return false;
+    }
+    const FlightRecord *rec = reinterpret_cast<const FlightRecord *>(view.storage.data());
+    size_t n = num_joints_;
+
+    view.frame = frame;
+    view.cycle = rec->cycle;
+    view.timestamp_ns = rec->timestamp_ns;
+    view.flags = rec->flags;
+
+    const double *d = reinterpret_cast<const double *>(rec + 1);
+    view.position = d;
+    view.velocity = d + n;
+    view.torque = d + 2 * n;
+    view.command_position = d + 3 * n;
+    view.command_velocity = d + 4 * n;
+    view.command_torque = d + 5 * n;
+
+    const int32_t *i = reinterpret_cast<const int32_t *>(d + FLIGHT_RECORD_DOUBLE_ARRAYS * n);
+    view.present_position = i;
+    view.present_velocity = i + n;
+    view.present_current = i + 2 * n;
+    view.present_temperature = i + 3 * n;
+    view.goal_position = i + 4 * n;
+    view.goal_velocity = i + 5 * n;
+    view.goal_current = i + 6 * n;
+    view.hardware_error = i + 7 * n;
+    view.position_p_gain = i + 8 * n;
+    view.position_d_gain = i + 9 * n;
+    view.velocity_p_gain = i + 10 * n;
+
+    return true;
+}
+
+bool FlightRecorder::getFrameRange(uint64_t &first, uint64_t &last) const
+{
+    uint64_t tag = header_->last_frame_tag.load(std::memory_order_acquire);
+    if (tag == 0)
+    {
+        return false;
+    }
+    last = tag - 1;
+    first = (tag > header_->capacity) ? tag - header_->capacity : 0;
+    return true;
+}
+
+size_t FlightRecorder::getNumJoints() const
+{
+    return num_joints_;
+}
+
+double FlightRecorder::getPeriod() const
+{
+    return header_->period;
+}
@@ -0,0 +1,232 @@
+#include "LoopStatus.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+static_assert(sizeof(LoopStatusBlock) == 256, "LoopStatusBlock must be 256 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "atomic<uint64_t> must be lock-free in shared memory");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be 32 bits");
+
+namespace
+{
+    // the segment is shared between processes, so the futex operations are not private
+    long futex(std::atomic<uint32_t> *word, int op, uint32_t value, const struct timespec *timeout)
+    {
+        return syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), op, value, timeout, nullptr, 0);
+    }
+}
+
+LoopStatus::LoopStatus()
+    : block_(nullptr),
+      owner_(false)
+{
+}
+
+LoopStatus::~LoopStatus()
+{
+    close();
+    if (owner_ && !name_.empty())
+    {
+        shm_unlink(name_.c_str());
+    }
+}
+
+bool LoopStatus::create(const std::string &name, int64_t period_ns, CycleScheduler::OverrunPolicy policy, bool free_run, bool lockstep)
+{
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0)
+    {
+        std::cerr << "shm_open failed: " << name << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, sizeof(LoopStatusBlock)) != 0)
+    {
+        std::cerr << "ftruncate failed: " << name << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void *addr = mmap(nullptr, sizeof(LoopStatusBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        std::cerr << "mmap failed: " << name << std::endl;
+        return false;
+    }
+    name_ = name;
+    owner_ = true;
+
+    std::memset(addr, 0, sizeof(LoopStatusBlock));
+    block_ = new (addr) LoopStatusBlock();
+    block_->period_ns = period_ns;
+    block_->overrun_policy = (uint32_t)policy;
+    block_->free_run = free_run ? 1 : 0;
+    block_->lockstep = lockstep ? 1 : 0;
+    block_->version = LOOP_STATUS_VERSION;
+    // The magic is written last, so a client never sees a partially initialized block
+    std::atomic_thread_fence(std::memory_order_release);
+    block_->magic = LOOP_STATUS_MAGIC;
+
+    return true;
+}
+
+bool LoopStatus::open(const std::string &name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0666);
+    if (fd < 0)
+    {
+        std::cerr << "shm_open failed: " << name << std::endl;
+        return false;
+    }
+    void *addr = mmap(nullptr, sizeof(LoopStatusBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        std::cerr << "mmap failed: " << name << std::endl;
+        return false;
+    }
+    LoopStatusBlock *block = static_cast<LoopStatusBlock *>(addr);
+    if (block->magic != LOOP_STATUS_MAGIC || block->version != LOOP_STATUS_VERSION)
+    {
+        std::cerr << "loop status " << name << " is not initialized or of another version" << std::endl;
+        munmap(addr, sizeof(LoopStatusBlock));
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    name_ = name;
+    owner_ = false;
+    block_ = block;
+    return true;
+}
+
+void LoopStatus::close()
+{
+    if (block_ != nullptr)
+    {
+        munmap(block_, sizeof(LoopStatusBlock));
+        block_ = nullptr;
+    }
+}
+
+void LoopStatus::update(const CycleStatistics &statistics)
+{
+    if (block_ == nullptr)
+    {
+        return;
+    }
+    block_->overruns.store(statistics.overruns, std::memory_order_relaxed);
+    block_->skipped_cycles.store(statistics.skipped_cycles, std::memory_order_relaxed);
+    block_->last_overrun_ns.store(statistics.last_overrun_ns, std::memory_order_relaxed);
+    block_->worst_overrun_ns.store(statistics.worst_overrun_ns, std::memory_order_relaxed);
+    block_->miss_streak.store(statistics.miss_streak, std::memory_order_relaxed);
+    block_->max_miss_streak.store(statistics.max_miss_streak, std::memory_order_relaxed);
+    // cycles is stored last, a client reading it first sees the counters of that cycle or later
+    block_->cycles.store(statistics.cycles, std::memory_order_release);
+}
+
+void LoopStatus::updateTransactions(int64_t read_ns, int64_t auxiliary_ns, int64_t write_ns)
+{
+    if (block_ == nullptr)
+    {
+        return;
+    }
+    block_->read_ns.store(read_ns, std::memory_order_relaxed);
+    block_->auxiliary_ns.store(auxiliary_ns, std::memory_order_relaxed);
+    block_->write_ns.store(write_ns, std::memory_order_relaxed);
+}
+
+void LoopStatus::updateCycleTime(int64_t mean_cycle_ns)
+{
+    if (block_ == nullptr)
+    {
+        return;
+    }
+    block_->mean_cycle_ns.store(mean_cycle_ns, std::memory_order_relaxed);
+}
+
+void LoopStatus::updateFrame(uint64_t frame, int64_t timestamp_ns)
+{
+    if (block_ == nullptr)
+    {
+        return;
+    }
+    // frame is stored last, a client reading frame, timestamp and frame again gets a consistent pair when both frames match
+    block_->frame_timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+    block_->frame.store(frame, std::memory_order_release);
+}
+
+uint32_t LoopStatus::getCommandSequence() const
+{
+    return (block_ != nullptr) ? block_->command_sequence.load(std::memory_order_acquire) : 0;
+}
+
+uint32_t LoopStatus::getStateSequence() const
+{
+    return (block_ != nullptr) ? block_->state_sequence.load(std::memory_order_acquire) : 0;
+}
+
+bool LoopStatus::waitCommand(uint32_t &sequence, int64_t timeout_ns)
+{
+    return (block_ != nullptr) && waitSequence(block_->command_sequence, sequence, timeout_ns);
+}
+
+void LoopStatus::signalState()
+{
+    if (block_ != nullptr)
+    {
+        signalSequence(block_->state_sequence);
+    }
+}
+
+void LoopStatus::signalCommand()
+{
+    if (block_ != nullptr)
+    {
+        signalSequence(block_->command_sequence);
+    }
+}
+
+bool LoopStatus::waitState(uint32_t &sequence, int64_t timeout_ns)
+{
+    return (block_ != nullptr) && waitSequence(block_->state_sequence, sequence, timeout_ns);
+}
+
+bool LoopStatus::waitSequence(std::atomic<uint32_t> &word, uint32_t &sequence, int64_t timeout_ns)
+{
+    int64_t deadline_ns = CycleScheduler::now() + timeout_ns;
+    while (true)
+    {
+        uint32_t current = word.load(std::memory_order_acquire);
+        if (current != sequence)
+        {
+            sequence = current;
+            return true;
+        }
+        int64_t remaining_ns = deadline_ns - CycleScheduler::now();
+        if (remaining_ns <= 0)
+        {
+            return false;
+        }
+        struct timespec ts;
+        ts.tv_sec = remaining_ns / 1000000000;
+        ts.tv_nsec = remaining_ns % 1000000000;
+        // returns at once (EAGAIN) when the word changed after the load
+        if (futex(&word, FUTEX_WAIT, current, &ts) != 0 && errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT)
+        {
+            return false;
+        }
+    }
+}
+
+void LoopStatus::signalSequence(std::atomic<uint32_t> &word)
+{
+    word.fetch_add(1, std::memory_order_release);
+    futex(&word, FUTEX_WAKE, INT32_MAX, nullptr);
+}
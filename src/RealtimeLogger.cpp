@@ -0,0 +1,224 @@
+#include "RealtimeLogger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+RealtimeLogger &RealtimeLogger::instance()
+{
+    static RealtimeLogger logger;
+    return logger;
+}
+
+RealtimeLogger::RealtimeLogger()
+    : mask_(0),
+      running_(false),
+      producers_(0),
+      dropped_(0),
+      enqueue_pos_(0),
+      dequeue_pos_(0)
+{
+}
+
+RealtimeLogger::~RealtimeLogger()
+{
+    stop();
+}
+
+bool RealtimeLogger::start(size_t capacity)
+{
+    if (running_.load())
+    {
+        return false;
+    }
+
+    size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    messages_.reset(new Message[size]);
+    for (size_t i = 0; i < size; i++)
+    {
+        messages_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask_ = size - 1;
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&RealtimeLogger::run, this);
+    return true;
+}
+
+void RealtimeLogger::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+
+    // Messages are written directly from now on. Those enqueued after the last
+    // drain of the writer thread are written here, once their producers finished.
+    while (producers_.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+    char text[MESSAGE_LENGTH];
+    Stream stream;
+    while (pop(stream, text))
+    {
+        write(stream, text);
+    }
+    std::fflush(stdout);
+}
+
+void RealtimeLogger::log(Stream stream, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vlog(stream, 0, format, args);
+    va_end(args);
+}
+
+void RealtimeLogger::logLimited(RateLimit &limit, Stream stream, const char *format, ...)
+{
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count();
+    int64_t next = limit.next_ns.load(std::memory_order_relaxed);
+    if (now < next || !limit.next_ns.compare_exchange_strong(next, now + limit.interval_ns, std::memory_order_relaxed))
+    {
+        limit.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    vlog(stream, limit.suppressed.exchange(0, std::memory_order_relaxed), format, args);
+    va_end(args);
+}
+
+uint64_t RealtimeLogger::getDroppedMessages() const
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void RealtimeLogger::vlog(Stream stream, uint32_t suppressed, const char *format, va_list args)
+{
+    // stop() waits for the producers that saw running_ before its final drain
+    producers_.fetch_add(1);
+    if (!running_.load())
+    {
+        producers_.fetch_sub(1);
+        // no writer thread, write directly
+        char text[MESSAGE_LENGTH];
+        formatMessage(text, suppressed, format, args);
+        write(stream, text);
+        return;
+    }
+
+    // reserve a slot
+    Message *message = nullptr;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        message = &messages_[pos & mask_];
+        size_t sequence = message->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0)
+        {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // queue is full
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            producers_.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+        else
+        {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    message->stream = stream;
+    formatMessage(message->text, suppressed, format, args);
+    message->sequence.store(pos + 1, std::memory_order_release);
+    producers_.fetch_sub(1, std::memory_order_release);
+}
+
+void RealtimeLogger::formatMessage(char *text, uint32_t suppressed, const char *format, va_list args)
+{
+    int length = vsnprintf(text, MESSAGE_LENGTH, format, args);
+    if (suppressed > 0 && length >= 0 && (size_t)length < MESSAGE_LENGTH)
+    {
+        snprintf(text + length, MESSAGE_LENGTH - length, " (%u similar messages suppressed)", suppressed);
+    }
+}
+
+bool RealtimeLogger::pop(Stream &stream, char *text)
+{
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Message *message = &messages_[pos & mask_];
+    if (message->sequence.load(std::memory_order_acquire) != pos + 1)
+    {
+        return false;
+    }
+
+    stream = message->stream;
+    std::memcpy(text, message->text, MESSAGE_LENGTH);
+    message->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+void RealtimeLogger::run()
+{
+    char text[MESSAGE_LENGTH];
+    Stream stream;
+    uint64_t reported_dropped = 0;
+
+    while (true)
+    {
+        bool running = running_.load(std::memory_order_acquire);
+        bool written = false;
+        while (pop(stream, text))
+        {
+            write(stream, text);
+            written = true;
+        }
+
+        uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reported_dropped)
+        {
+            std::fprintf(stderr, "logger: %llu messages dropped\n", (unsigned long long)(dropped - reported_dropped));
+            reported_dropped = dropped;
+        }
+
+        if (written)
+        {
+            std::fflush(stdout);
+        }
+        if (!running)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void RealtimeLogger::write(Stream stream, const char *text)
+{
+    FILE *fp = (stream == Err) ? stderr : stdout;
+    std::fputs(text, fp);
+    std::fputc('\n', fp);
+}
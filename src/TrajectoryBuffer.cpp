@@ -0,0 +1,206 @@
+#include "TrajectoryBuffer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+static_assert(sizeof(TrajectoryRingHeader) == 64, "TrajectoryRingHeader must be 64 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "atomic<uint64_t> must be lock-free in shared memory");
+
+TrajectoryBuffer::TrajectoryBuffer()
+    : owner_(false),
+      addr_(nullptr),
+      size_(0),
+      stride_(0),
+      header_(nullptr),
+      segments_(nullptr)
+{
+}
+
+TrajectoryBuffer::~TrajectoryBuffer()
+{
+    close();
+    if (owner_)
+    {
+        shm_unlink(name_.c_str());
+    }
+}
+
+bool TrajectoryBuffer::create(const std::string &name, size_t num_joints, size_t capacity)
+{
+    name_ = name;
+    stride_ = 2 + num_joints * 4;
+    size_ = sizeof(TrajectoryRingHeader) + capacity * stride_ * sizeof(double);
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0)
+    {
+        std::cerr << "shm_open failed: " << name << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, size_) != 0)
+    {
+        std::cerr << "ftruncate failed: " << name << std::endl;
+        ::close(fd);
+        return false;
+    }
+    addr_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr_ == MAP_FAILED)
+    {
+        std::cerr << "mmap failed: " << name << std::endl;
+        addr_ = nullptr;
+        return false;
+    }
+    owner_ = true;
+
+    std::memset(addr_, 0, size_);
+    header_ = new (addr_) TrajectoryRingHeader();
+    header_->num_joints = num_joints;
+    header_->capacity = capacity;
+    header_->version = TRAJECTORY_RING_VERSION;
+    header_->write_index.store(0, std::memory_order_relaxed);
+    header_->read_index.store(0, std::memory_order_relaxed);
+    segments_ = reinterpret_cast<double *>(static_cast<uint8_t *>(addr_) + sizeof(TrajectoryRingHeader));
+    // The magic is written last, so a client never sees a partially initialized header
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = TRAJECTORY_RING_MAGIC;
+
+    return true;
+}
+
+bool TrajectoryBuffer::open(const std::string &name)
+{
+    name_ = name;
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0666);
+    if (fd < 0)
+    {
+        std::cerr << "shm_open failed: " << name << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TrajectoryRingHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+    size_ = st.st_size;
+    addr_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr_ == MAP_FAILED)
+    {
+        addr_ = nullptr;
+        return false;
+    }
+
+    header_ = static_cast<TrajectoryRingHeader *>(addr_);
+    if (header_->magic != TRAJECTORY_RING_MAGIC || header_->version != TRAJECTORY_RING_VERSION)
+    {
+        std::cerr << "Trajectory buffer header mismatch: " << name << std::endl;
+        close();
+        return false;
+    }
+    stride_ = 2 + header_->num_joints * 4;
+    segments_ = reinterpret_cast<double *>(static_cast<uint8_t *>(addr_) + sizeof(TrajectoryRingHeader));
+
+    return true;
+}
+
+void TrajectoryBuffer::close()
+{
+    if (addr_ != nullptr)
+    {
+        munmap(addr_, size_);
+        addr_ = nullptr;
+        header_ = nullptr;
+        segments_ = nullptr;
+    }
+}
+
+double *TrajectoryBuffer::segmentAt(uint64_t index) const
+{
+    return segments_ + (index % header_->capacity) * stride_;
+}
+
+bool TrajectoryBuffer::push(double start_time, double duration, const double *coeffs)
+{
+    uint64_t w = header_->write_index.load(std::memory_order_relaxed);
+    uint64_t r = header_->read_index.load(std::memory_order_acquire);
+    // The active segment must not be overwritten
+    if (w - r >= header_->capacity)
+    {
+        return false;
+    }
+
+    double *seg = segmentAt(w);
+    seg[0] = start_time;
+    seg[1] = duration;
+    std::memcpy(seg + 2, coeffs, header_->num_joints * 4 * sizeof(double));
+
+    header_->write_index.store(w + 1, std::memory_order_release);
+    return true;
+}
+
+bool TrajectoryBuffer::evaluate(double now, std::vector<irsl_shm_controller::irsl_float_type> &pos_vec)
+{
+    uint64_t w = header_->write_index.load(std::memory_order_acquire);
+    uint64_t r = header_->read_index.load(std::memory_order_relaxed);
+    if (r >= w)
+    {
+        return false;
+    }
+
+    // Advance to the latest segment that has started
+    while (r + 1 < w && segmentAt(r + 1)[0] <= now)
+    {
+        r++;
+    }
+    header_->read_index.store(r, std::memory_order_release);
+
+    // Only a segment pushed into an empty ring can start in the future
+    const double *seg = segmentAt(r);
+    if (now < seg[0])
+    {
+        return false;
+    }
+    // The last segment has ended: its final position is returned once and the ring is released
+    if (r + 1 == w && now >= seg[0] + seg[1])
+    {
+        header_->read_index.store(w, std::memory_order_release);
+    }
+
+    size_t num_joints = header_->num_joints;
+    if (pos_vec.size() != num_joints)
+    {
+        pos_vec.resize(num_joints);
+    }
+
+    const double t = std::min(std::max(now - seg[0], 0.0), seg[1]);
+    const double *c = seg + 2;
+    for (size_t i = 0; i < num_joints; i++, c += 4)
+    {
+        pos_vec[i] = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+    }
+
+    return true;
+}
+
+double TrajectoryBuffer::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+size_t TrajectoryBuffer::getNumJoints() const
+{
+    return (header_ != nullptr) ? header_->num_joints : 0;
+}
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+
+#include "CLI11.hpp"
+
+#include "FlightRecorder.h"
+
+static void print_header(size_t num_joints)
+{
+    static const char *names[] = {
+        "position", "velocity", "torque",
+        "command_position", "command_velocity", "command_torque",
+        "present_position", "present_velocity", "present_current", "present_temperature",
+        "goal_position", "goal_velocity", "goal_current", "hardware_error",
+        "position_p_gain", "position_d_gain", "velocity_p_gain"};
+
+    std::cout << "frame,cycle,timestamp_ns,flags";
+    for (const char *name : names)
+    {
+        for (size_t j = 0; j < num_joints; j++)
+        {
+            std::cout << "," << name << "_" << j;
+        }
+    }
+    std::cout << "\n";
+}
+
+template <typename T>
+static void print_array(const T *values, size_t num_joints)
+{
+    for (size_t j = 0; j < num_joints; j++)
+    {
+        std::cout << "," << values[j];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string fname;
+    uint64_t from = 0;
+    uint64_t to = std::numeric_limits<uint64_t>::max();
+
+    CLI::App vm{"Dump a flight recorder file to CSV"};
+    vm.add_option("record_file", fname, "flight recorder file")->required();
+    vm.add_option("--from", from, "first shared memory frame");
+    vm.add_option("--to", to, "last shared memory frame");
+    CLI11_PARSE(vm, argc, argv);
+
+    FlightRecorder recorder;
+    if (!recorder.open(fname))
+    {
+        return -1;
+    }
+
+    size_t n = recorder.getNumJoints();
+    print_header(n);
+
+    uint64_t first, last;
+    if (!recorder.getFrameRange(first, last))
+    {
+        return 0;
+    }
+    first = std::max(first, from);
+    last = std::min(last, to);
+
+    std::cout.precision(std::numeric_limits<double>::max_digits10);
+    FlightRecordView view;
+    for (uint64_t frame = first; frame <= last; frame++)
+    {
+        // frames overwritten or never recorded are skipped
+        if (!recorder.getRecord(frame, view))
+        {
+            continue;
+        }
+        std::cout << view.frame << "," << view.cycle << "," << view.timestamp_ns << "," << view.flags;
+        print_array(view.position, n);
+        print_array(view.velocity, n);
+        print_array(view.torque, n);
+        print_array(view.command_position, n);
+        print_array(view.command_velocity, n);
+        print_array(view.command_torque, n);
+        print_array(view.present_position, n);
+        print_array(view.present_velocity, n);
+        print_array(view.present_current, n);
+        print_array(view.present_temperature, n);
+        print_array(view.goal_position, n);
+        print_array(view.goal_velocity, n);
+        print_array(view.goal_current, n);
+        print_array(view.hardware_error, n);
+        print_array(view.position_p_gain, n);
+        print_array(view.position_d_gain, n);
+        print_array(view.velocity_p_gain, n);
+        std::cout << "\n";
+    }
+
+    return 0;
+}
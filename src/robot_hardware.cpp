@@ -1,4 +1,8 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <thread>
 
 #include "irsl/shm_controller.h"
 #include "irsl/realtime_task.h"
@@ -11,6 +15,15 @@ using namespace irsl_shm_controller;
 using namespace irsl_realtime_task;
 
 #include "DynamixelInterface.h"
+#include "CommandInterpolator.h"
+#include "TrajectoryBuffer.h"
+#include "HardwareFrame.h"
+#include "SpscRing.h"
+#include "RealtimeLogger.h"
+#include "FlightRecorder.h"
+#include "BusPlanner.h"
+#include "CycleScheduler.h"
+#include "LoopStatus.h"
 #include "common.h"
 
 #include <unordered_map>
@@ -26,6 +39,11 @@ static const std::unordered_map<std::string, int> jointTypeMap = {
     {"MotorCurrent", ShmSettings::JointType::MotorCurrent},
 };
 
+// Bus utilization above which a warning is printed at startup
+static const double BUS_UTILIZATION_WARNING = 0.8;
+// the lockstep loop wakes this often while the controller is silent [nsec]
+static const int64_t LOCKSTEP_TIMEOUT_NS = 100000000;
+
 void status_print(
     const std::vector<irsl_float_type>& cur_pos_float_vec,
     const std::vector<irsl_float_type>& cur_vel_float_vec)
@@ -34,10 +52,240 @@ void status_print(
 
     for (size_t i = 0; i < n; i++)
     {
-        std::cout << i << " "
-                  << cur_pos_float_vec[i] << " "
-                  << cur_vel_float_vec[i] << std::endl;
+        RealtimeLogger::instance().log(RealtimeLogger::Out, "%zu %g %g", i,
+                                       (double)cur_pos_float_vec[i], (double)cur_vel_float_vec[i]);
+    }
+}
+
+/**
+ * @brief Streams a recorded session to shered memory instead of the Dynamixels.
+ *
+ * The recorded state is written at the recorded period (or as fast as possible),
+ * and the commands and gains written back by the controller are recorded when record_file is given.
+ */
+int run_replay(
+    ShmSettings &ss,
+    const std::string &replay_file,
+    bool replay_fast,
+    const std::string &record_file,
+    size_t record_length)
+{
+    FlightRecorder replay;
+    if (!replay.open(replay_file))
+    {
+        return -1;
+    }
+    uint64_t first, last;
+    if (!replay.getFrameRange(first, last))
+    {
+        std::cerr << "flight recorder file [" << replay_file << "] is empty" << std::endl;
+        return -1;
+    }
+
+    size_t joint_num = replay.getNumJoints();
+    ss.numJoints = joint_num;
+    if (ss.jointType & ShmSettings::JointType::MotorCurrent)
+    {
+        std::cerr << "MotorCurrent is not recorded and is not replayed" << std::endl;
+    }
+
+    ShmManager sm(ss);
+    if (!sm.openSharedMemory(true) || !sm.writeHeader())
+    {
+        std::cerr << "failed to open shered memory" << std::endl;
+        return -1;
+    }
+    sm.resetFrame();
+
+    FlightRecorder recorder;
+    if (!record_file.empty() && !recorder.create(record_file, joint_num, record_length, replay.getPeriod()))
+    {
+        return -1;
+    }
+
+    std::vector<irsl_float_type> pos_float_vec(joint_num);
+    std::vector<irsl_float_type> vel_float_vec(joint_num);
+    std::vector<irsl_float_type> torque_float_vec(joint_num);
+    std::vector<irsl_float_type> temp_float_vec(joint_num);
+    std::vector<irsl_float_type> cmd_pos_float_vec(joint_num);
+    std::vector<irsl_float_type> cmd_vel_float_vec(joint_num);
+    std::vector<irsl_float_type> cmd_torque_float_vec(joint_num);
+    std::vector<irsl_float_type> gain_float_vec(joint_num);
+    StateFrame state(joint_num);
+    CommandFrame command(joint_num); // no raw goals without Dynamixels, only gains
+
+    // gains are raw values of Dynamixel also in shered memory
+    auto gain_from_raw = [&](const int32_t *raw) -> const std::vector<irsl_float_type> &
+    {
+        gain_float_vec.assign(raw, raw + joint_num);
+        return gain_float_vec;
+    };
+    auto gain_to_raw = [&](std::vector<int32_t> &raw)
+    {
+        for (size_t i = 0; i < joint_num; i++)
+        {
+            raw[i] = std::max<int32_t>(0, (int32_t)std::lround(gain_float_vec[i]));
+        }
+    };
+
+    // start from the first recorded state
+    FlightRecordView view;
+    bool found = false;
+    for (uint64_t frame = first; frame <= last && !found; frame++)
+    {
+        if (replay.getRecord(frame, view))
+        {
+            first = frame;
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        std::cerr << "flight recorder file [" << replay_file << "] has no complete record" << std::endl;
+        return -1;
+    }
+    if (ss.jointType & ShmSettings::JointType::PositionCommand)
+    {
+        cmd_pos_float_vec.assign(view.position, view.position + joint_num);
+        sm.writePositionCommand(cmd_pos_float_vec);
+    }
+    if (ss.jointType & ShmSettings::JointType::VelocityCommand)
+    {
+        cmd_vel_float_vec.assign(view.velocity, view.velocity + joint_num);
+        sm.writeVelocityCommand(cmd_vel_float_vec);
+    }
+    if (ss.jointType & ShmSettings::JointType::TorqueCommand)
+    {
+        sm.writeTorqueCommand(cmd_torque_float_vec);
+    }
+    // start from the recorded gains, as from the gains held by Dynamixel
+    if (ss.jointType & ShmSettings::JointType::PositionGains)
+    {
+        sm.writePGain(gain_from_raw(view.position_p_gain));
+        sm.writeDGain(gain_from_raw(view.position_d_gain));
+    }
+    if (ss.jointType & ShmSettings::JointType::VelocityGains)
+    {
+        sm.writeVelocityPGain(gain_from_raw(view.velocity_p_gain));
+    }
+
+    double period_sec = replay.getPeriod();
+    unsigned long interval_ns = (unsigned long)(period_sec * 1000000000);
+    IntervalStatistics tm((unsigned long)(period_sec * 1000000));
+
+    // consumers wait for frames on the status segment as with Dynamixels
+    LoopStatus loop_status;
+    if (!loop_status.create("/irsl_dynamixel_status_" + std::to_string(ss.shm_key),
+                            replay_fast ? 0 : (int64_t)interval_ns, CycleScheduler::OverrunPolicy::CatchUp, replay_fast, false))
+    {
+        return -1;
+    }
+
+    std::cout << "replay: " << replay_file << " frames " << first << "-" << last << std::endl;
+    uint64_t replayed = 0;
+    tm.start();
+    for (uint64_t frame = first; frame <= last; frame++)
+    {
+        // frames overwritten while recording are skipped
+        if (!replay.getRecord(frame, view))
+        {
+            continue;
+        }
+        if (!replay_fast)
+        {
+            tm.sleepUntil(interval_ns);
+            tm.sync();
+        }
+
+        pos_float_vec.assign(view.position, view.position + joint_num);
+        vel_float_vec.assign(view.velocity, view.velocity + joint_num);
+        torque_float_vec.assign(view.torque, view.torque + joint_num);
+
+        // write to sheread memory
+        sm.writePositionCurrent(pos_float_vec);
+        sm.writeVelocityCurrent(vel_float_vec);
+        sm.writeTorqueCurrent(torque_float_vec);
+        if (ss.jointType & ShmSettings::JointType::MotorTemperature)
+        {
+            // Present_Temperature is 1 [degC] per unit on all models
+            temp_float_vec.assign(view.present_temperature, view.present_temperature + joint_num);
+            sm.writeMotorTemperature(temp_float_vec);
+        }
+
+        if (recorder.isOpen())
+        {
+            // record the commands written back by the controller
+            if (ss.jointType & ShmSettings::JointType::PositionCommand)
+            {
+                sm.readPositionCommand(cmd_pos_float_vec);
+            }
+            if (ss.jointType & ShmSettings::JointType::VelocityCommand)
+            {
+                sm.readVelocityCommand(cmd_vel_float_vec);
+            }
+            if (ss.jointType & ShmSettings::JointType::TorqueCommand)
+            {
+                sm.readTorqueCommand(cmd_torque_float_vec);
+            }
+            if (ss.jointType & ShmSettings::JointType::PositionGains)
+            {
+                sm.readPGain(gain_float_vec);
+                gain_to_raw(command.position_p_gain);
+                sm.readDGain(gain_float_vec);
+                gain_to_raw(command.position_d_gain);
+            }
+            if (ss.jointType & ShmSettings::JointType::VelocityGains)
+            {
+                sm.readVelocityPGain(gain_float_vec);
+                gain_to_raw(command.velocity_p_gain);
+            }
+
+            state.cycle = view.cycle;
+            state.timestamp_ns = view.timestamp_ns;
+            state.flags = view.flags;
+            state.position.assign(view.present_position, view.present_position + joint_num);
+            state.velocity.assign(view.present_velocity, view.present_velocity + joint_num);
+            state.current.assign(view.present_current, view.present_current + joint_num);
+            state.temperature.assign(view.present_temperature, view.present_temperature + joint_num);
+            state.hardware_error.assign(view.hardware_error, view.hardware_error + joint_num);
+            recorder.record(sm.getFrame(), state,
+                            pos_float_vec, vel_float_vec, torque_float_vec,
+                            command,
+                            cmd_pos_float_vec, cmd_vel_float_vec, cmd_torque_float_vec);
+        }
+
+        sm.incrementFrame();
+        loop_status.updateFrame(sm.getFrame(), view.timestamp_ns);
+        loop_status.signalState();
+        replayed++;
+    }
+    std::cout << "replayed " << replayed << " frames" << std::endl;
+
+    return 0;
+}
+
+/**
+ * @brief Prints the bus plan and checks that the bus can sustain the period.
+ *
+ * @return true The predicted cycle time fits in the period (or ignore_plan is set)
+ * @return false The period can not be met
+ */
+bool check_bus_plan(const BusPlanner &plan, double period_sec, bool ignore_plan)
+{
+    plan.print(std::cout, period_sec);
+
+    double utilization = plan.getUtilization(period_sec);
+    if (utilization > 1.0)
+    {
+        std::cerr << "period " << period_sec << " [sec] can not be met: the bus needs " << plan.getCycleTime()
+                  << " [sec] per cycle (max rate " << plan.getMaxRate() << " [Hz])" << std::endl;
+        return ignore_plan;
+    }
+    if (utilization > BUS_UTILIZATION_WARNING)
+    {
+        std::cerr << "bus utilization " << utilization * 100.0 << " [%] leaves little margin for retries and jitter" << std::endl;
     }
+    return true;
 }
 
 int main(int argc, char **argv)
@@ -47,15 +295,67 @@ int main(int argc, char **argv)
     int32_t shm_key ;
     std::vector<std::string> joint_types = {"PositionGains", "PositionCommand"};
     bool verbose = false;
+    std::string interpolation = "hold";
+    double command_period = 0.0;
+    bool use_trajectory = false;
+    bool use_publisher_thread = false;
+    std::string record_file;
+    size_t record_length = 10000;
+    std::string replay_file;
+    bool replay_fast = false;
+    bool plan_only = false;
+    bool ignore_bus_plan = false;
+    std::string overrun_policy = "catch_up";
+    double spin_guard_usec = 0.0;
+    bool free_run = false;
+    bool lockstep = false;
 
     CLI::App vm{"Dynamixel controller"};
     vm.add_option("shm_hash", shm_hash, "sherad memory hash")->default_val("8888");
     vm.add_option("shm_key", shm_key, "sherad memory key")->default_val("8888");
     vm.add_option("config_file", fname, "name of input file(.yaml)")->default_val("config.yaml");
     vm.add_option("--joint_type", joint_types, "Joint types");
+    vm.add_option("--interpolation", interpolation, "Position command interpolation (hold, linear, cubic)")->default_val("hold");
+    vm.add_option("--command_period", command_period, "Update period of the controller [sec] (default: period)");
+    vm.add_flag("--trajectory", use_trajectory, "Execute trajectories streamed to /irsl_dynamixel_trajectory_<shm_key>");
+    vm.add_flag("--publisher_thread", use_publisher_thread, "Publish to shered memory from a separate thread");
+    vm.add_option("--record", record_file, "Record every cycle to a flight recorder file");
+    vm.add_option("--record_length", record_length, "Number of cycles kept in the flight recorder file")->default_val("10000");
+    vm.add_option("--replay", replay_file, "Replay a flight recorder file to shered memory without Dynamixels (recorded gains are written once at start)");
+    vm.add_flag("--replay_fast", replay_fast, "Replay as fast as possible instead of at the recorded period");
+    vm.add_option("--overrun_policy", overrun_policy, "What to do when a cycle is late (catch_up, skip, realign)")->default_val("catch_up");
+    vm.add_option("--spin_guard", spin_guard_usec, "Busy-wait before each deadline [usec] (0: sleep only)")->default_val("0");
+    vm.add_flag("--free_run", free_run, "Start each cycle as soon as the previous one ends, ignoring period");
+    vm.add_flag("--lockstep", lockstep, "Run one cycle each time the controller signals a command");
+    vm.add_flag("--plan", plan_only, "Print the bus plan estimated from the config file and exit");
+    vm.add_flag("--ignore_bus_plan", ignore_bus_plan, "Start even if the bus can not sustain the period");
     vm.add_flag("-v,--verbose", verbose, "verbose message");
     CLI11_PARSE(vm, argc, argv);
 
+    ShmSettings ss;
+    ss.hash = shm_hash;
+    ss.shm_key = shm_key;
+
+    ss.numForceSensors = 0;
+    ss.numImuSensors = 0;
+    ss.jointType = 0;
+
+    for (const auto &jtype : joint_types)
+    {
+        auto it = jointTypeMap.find(jtype);
+        if (it != jointTypeMap.end())
+        {
+            ss.jointType |= it->second;
+        }
+    }
+    std::cout << "jointType : " << ss.jointType << std::endl;
+
+    if (!replay_file.empty())
+    {
+        // no bus, the recorded state drives the shered memory
+        return run_replay(ss, replay_file, replay_fast, record_file, record_length);
+    }
+
     YAML::Node n;
     try
     {
@@ -70,32 +370,94 @@ int main(int argc, char **argv)
 
     YAML::Node hardware_settings = n[hardware_setings_name];
 
-    DynamixelInterface di;
-    bool ret;
-    ret = di.initialize(hardware_settings);
-    if (!ret)
+    CycleScheduler::OverrunPolicy overrun_policy_value;
+    if (!CycleScheduler::parsePolicy(overrun_policy, overrun_policy_value))
     {
+        std::cerr << "unknown overrun policy [" << overrun_policy << "]" << std::endl;
         return -1;
     }
 
-    ShmSettings ss;
-    ss.hash = shm_hash;
-    ss.shm_key = shm_key;
+    if (lockstep && (free_run || use_publisher_thread))
+    {
+        std::cerr << "--lockstep can not be combined with --free_run or --publisher_thread" << std::endl;
+        return -1;
+    }
 
-    ss.numJoints = di.getNumberOfDynamixels();
-    ss.numForceSensors = 0;
-    ss.numImuSensors = 0;
-    ss.jointType = 0;
+    CommandInterpolator::Method interpolation_method;
+    if (!CommandInterpolator::parseMethod(interpolation, interpolation_method))
+    {
+        std::cerr << "unknown interpolation [" << interpolation << "]" << std::endl;
+        return -1;
+    }
 
-    for (const auto &jtype : joint_types)
+    // goal items written to Dynamixel
+    // (the mode of each joint is given by CommandMode or Operating_Mode in the config file)
+    std::vector<std::string> command_items;
+    if (ss.jointType & ShmSettings::JointType::PositionCommand)
     {
-        auto it = jointTypeMap.find(jtype);
-        if (it != jointTypeMap.end())
+        command_items.push_back("Goal_Position");
+    }
+    if (ss.jointType & ShmSettings::JointType::VelocityCommand)
+    {
+        command_items.push_back("Goal_Velocity");
+    }
+    if (ss.jointType & ShmSettings::JointType::TorqueCommand)
+    {
+        command_items.push_back("Goal_Current");
+    }
+
+    // gain items written to Dynamixel (each shered memory channel maps to the item of the same kind only)
+    std::vector<std::string> gain_items;
+    if (ss.jointType & ShmSettings::JointType::PositionGains)
+    {
+        gain_items.push_back("Position_P_Gain");
+        gain_items.push_back("Position_D_Gain");
+        std::cerr << "PositionGains: Position_I_Gain has no shered memory channel and keeps the value of DynamixelSettings" << std::endl;
+    }
+    if (ss.jointType & ShmSettings::JointType::VelocityGains)
+    {
+        // velocity loop of Dynamixel is PI control, it has no D gain
+        gain_items.push_back("Velocity_P_Gain");
+        std::cerr << "VelocityGains: the D gain channel is not supported by Dynamixel and is ignored, "
+                  << "Velocity_I_Gain keeps the value of DynamixelSettings" << std::endl;
+    }
+    if (ss.jointType & ShmSettings::JointType::TorqueGains)
+    {
+        std::cerr << "TorqueGains: Dynamixel has no torque loop gains, the channels are ignored" << std::endl;
+    }
+
+    if (plan_only)
+    {
+        // no bus access, the Dynamixels are assumed to be X series
+        BusPlanner plan;
+        if (!DynamixelInterface::estimateBusPlan(hardware_settings, command_items, plan))
         {
-            ss.jointType |= it->second;
+            return -1;
         }
+        double period = hardware_settings["period"] ? hardware_settings["period"].as<double>() : 0.0;
+        return check_bus_plan(plan, period, false) ? 0 : 1;
     }
-    std::cout << "jointType : " << ss.jointType << std::endl;
+
+    DynamixelInterface di;
+    di.setCommandItems(command_items);
+    di.setGainItems(gain_items);
+    bool ret;
+    ret = di.initialize(hardware_settings);
+    if (!ret)
+    {
+        return -1;
+    }
+
+    BusPlanner bus_plan;
+    di.planBus(bus_plan);
+    // a free running or lockstep loop has no period to meet, the plan shows the rate to expect
+    if (!check_bus_plan(bus_plan, (free_run || lockstep) ? 0.0 : hardware_settings["period"].as<double>(), ignore_bus_plan))
+    {
+        std::cerr << "raise period or baud_rate, or start with --ignore_bus_plan" << std::endl;
+        return -1;
+    }
+
+    ss.numJoints = di.getNumberOfDynamixels();
 
     ShmManager sm(ss);
     bool res;
@@ -122,7 +484,6 @@ int main(int argc, char **argv)
     IntervalStatistics tm(interval_us);
 
     int cntr = 0;
-    tm.start();
 
     size_t joint_num = di.getNumberOfDynamixels();
     std::vector<int32_t> cur_pos_vec(joint_num);
@@ -130,33 +491,115 @@ int main(int argc, char **argv)
     std::vector<int32_t> cur_cur_vec(joint_num);
     std::vector<irsl_float_type> cur_pos_float_vec(joint_num);
     std::vector<irsl_float_type> cur_vel_float_vec(joint_num);
-    // std::vector<irsl_float_type> cur_float_vec(joint_num);
+    std::vector<irsl_float_type> cur_cur_float_vec(joint_num);
     std::vector<irsl_float_type> cur_torque_float_vec(joint_num);
+    bool publish_current = ss.jointType & ShmSettings::JointType::MotorCurrent;
 
     std::vector<irsl_float_type> cmd_pos_float_vec(joint_num);
-    std::vector<int32_t> dynamixel_position(joint_num);
+    // position command sent to the joints (interpolated or evaluated from the trajectory)
+    std::vector<irsl_float_type> goal_pos_float_vec(joint_num);
+    CommandInterpolator interpolator;
+    interpolator.initialize(joint_num, interpolation_method,
+                            (command_period > 0.0) ? command_period : period_sec, period_sec);
+
+    TrajectoryBuffer trajectory;
+    bool trajectory_active = false;
+    if (use_trajectory)
+    {
+        std::string trajectory_name = "/irsl_dynamixel_trajectory_" + std::to_string(shm_key);
+        if (!trajectory.create(trajectory_name, joint_num, 256))
+        {
+            return -1;
+        }
+        std::cout << "trajectory buffer: " << trajectory_name << std::endl;
+    }
+
+    CycleScheduler scheduler;
+    scheduler.initialize(interval_ns, overrun_policy_value);
+    scheduler.setSpinGuard((int64_t)(spin_guard_usec * 1000));
+    // in lockstep, the controller paces the loop and the scheduler only counts cycles
+    scheduler.setFreeRun(free_run || lockstep);
+    LoopStatus loop_status;
+    std::string loop_status_name = "/irsl_dynamixel_status_" + std::to_string(shm_key);
+    if (!loop_status.create(loop_status_name, (free_run || lockstep) ? 0 : interval_ns, overrun_policy_value, free_run, lockstep))
+    {
+        return -1;
+    }
+    std::cout << "loop status: " << loop_status_name << std::endl;
+
+    FlightRecorder recorder;
+    if (!record_file.empty())
+    {
+        if (!recorder.create(record_file, joint_num, record_length, period_sec))
+        {
+            return -1;
+        }
+        std::cout << "flight recorder: " << record_file << std::endl;
+    }
 
     std::vector<irsl_float_type> cmd_vel_float_vec(joint_num);
-    std::vector<int32_t> dynamixel_velocity(joint_num);
+
+    std::vector<irsl_float_type> cmd_torque_float_vec(joint_num);
+
+    std::vector<irsl_float_type> gain_p_float_vec(joint_num);
+    std::vector<irsl_float_type> gain_d_float_vec(joint_num);
+
+    std::vector<int32_t> cur_temp_vec(joint_num);
+    std::vector<irsl_float_type> cur_temp_float_vec(joint_num);
+    bool publish_temperature = (ss.jointType & ShmSettings::JointType::MotorTemperature) &&
+                               di.getAuxiliaryItem("Present_Temperature", cur_temp_vec);
+    if ((ss.jointType & ShmSettings::JointType::MotorTemperature) && !publish_temperature)
+    {
+        std::cerr << "MotorTemperature requires Present_Temperature, which is neither packed into the feedback (indirect_address) nor in auxiliary_items" << std::endl;
+    }
+    // Hardware_Error_Status is available when it is packed into the feedback window or polled
+    std::vector<int32_t> hw_err_vec(joint_num);
+    std::vector<int32_t> last_hardware_error(joint_num, 0);
+    bool check_hardware_error = di.getAuxiliaryItem("Hardware_Error_Status", hw_err_vec);
 
     di.getDynamixelCurrentStatus(cur_pos_vec, cur_vel_vec, cur_cur_vec);
 
     di.convertPosition(cur_pos_vec, cur_pos_float_vec);
     di.convertVelocity(cur_vel_vec, cur_vel_float_vec);
-    di.convertTorque(cur_cur_vec, cur_torque_float_vec);
+    di.convertCurrentAndTorque(cur_cur_vec, cur_cur_float_vec, cur_torque_float_vec);
 
     sm.writePositionCurrent(cur_pos_float_vec);
     sm.writeVelocityCurrent(cur_vel_float_vec);
     sm.writeTorqueCurrent(cur_torque_float_vec);
+    if (publish_current)
+    {
+        sm.writeMotorCurrent(cur_cur_float_vec);
+    }
 
     if (ss.jointType & ShmSettings::JointType::PositionCommand)
     {
         sm.writePositionCommand(cur_pos_float_vec);
+        interpolator.reset(cur_pos_float_vec);
     }
-    else if (ss.jointType & ShmSettings::JointType::VelocityCommand)
+    if (ss.jointType & ShmSettings::JointType::VelocityCommand)
     {
         sm.writeVelocityCommand(cur_vel_float_vec);
     }
+    if (ss.jointType & ShmSettings::JointType::TorqueCommand)
+    {
+        // start from zero torque
+        std::fill(cmd_torque_float_vec.begin(), cmd_torque_float_vec.end(), 0.0);
+        sm.writeTorqueCommand(cmd_torque_float_vec);
+    }
+
+    // start from the gains held by Dynamixel
+    bool apply_position_gains = di.getGain("Position_P_Gain", gain_p_float_vec) &&
+                                di.getGain("Position_D_Gain", gain_d_float_vec);
+    if (apply_position_gains)
+    {
+        sm.writePGain(gain_p_float_vec);
+        sm.writeDGain(gain_d_float_vec);
+    }
+    bool apply_velocity_gains = di.getGain("Velocity_P_Gain", gain_p_float_vec);
+    if (apply_velocity_gains)
+    {
+        sm.writeVelocityPGain(gain_p_float_vec);
+    }
 
     // sm.writeTorqueCommand(cur_torque_float_vec);
     if (verbose)
@@ -164,57 +607,359 @@ int main(int argc, char **argv)
         status_print(cur_pos_float_vec, cur_vel_float_vec);
     }
 
-    while (true)
+    // raw frames handed from the bus side to the publisher side, and commands handed back
+    // (slots are preallocated, so no allocation happens while running)
+    StateFrame bus_state(joint_num);
+    CommandFrame bus_command(joint_num);
+    SpscRing<StateFrame> state_ring(16, bus_state);
+    SpscRing<CommandFrame> command_ring(16, bus_command);
+    CommandFrame last_command(joint_num);
+    // until the first command, the gains held by Dynamixel are recorded
+    if (apply_position_gains)
     {
-        tm.sleepUntil(interval_ns);
-        tm.sync();
-
+        di.getGain("Position_P_Gain", gain_p_float_vec);
+        di.convertGainCmd(gain_p_float_vec, last_command.position_p_gain);
+        di.getGain("Position_D_Gain", gain_d_float_vec);
+        di.convertGainCmd(gain_d_float_vec, last_command.position_d_gain);
+    }
+    if (apply_velocity_gains)
+    {
+        di.getGain("Velocity_P_Gain", gain_p_float_vec);
+        di.convertGainCmd(gain_p_float_vec, last_command.velocity_p_gain);
+    }
+    uint64_t bus_cycle = 0;
+    uint32_t bus_write_flags = 0;
+    uint32_t cycle_flags = 0;
+    int64_t read_ns = 0;
+    int64_t auxiliary_ns = 0;
+    int64_t write_ns = 0;
+    uint64_t dropped_state_frames = 0;
+    std::atomic<uint64_t> dropped_command_frames(0);
+
+    // bus side: serial transactions only (never touches ShmManager)
+    auto bus_read = [&]()
+    {
+        bus_state.flags = bus_write_flags | cycle_flags;
+        int64_t read_start = CycleScheduler::now();
         // read current value from Dynamixel
-        di.getDynamixelCurrentStatus(cur_pos_vec, cur_vel_vec, cur_cur_vec);
+        if (!di.getDynamixelCurrentStatus(bus_state.position, bus_state.velocity, bus_state.current))
+        {
+            bus_state.flags |= STATE_READ_FAILED;
+        }
+        int64_t auxiliary_start = CycleScheduler::now();
+        // read this cycle's share of the auxiliary items
+        if (!di.pollAuxiliaryItems())
+        {
+            bus_state.flags |= STATE_AUXILIARY_FAILED;
+        }
+        read_ns = auxiliary_start - read_start;
+        auxiliary_ns = CycleScheduler::now() - auxiliary_start;
+        if (publish_temperature)
+        {
+            di.getAuxiliaryItem("Present_Temperature", bus_state.temperature);
+        }
+        if (check_hardware_error)
+        {
+            di.getAuxiliaryItem("Hardware_Error_Status", bus_state.hardware_error);
+            for (size_t j = 0; j < joint_num; j++)
+            {
+                if (bus_state.hardware_error[j] != 0)
+                {
+                    bus_state.flags |= STATE_HARDWARE_ERROR;
+                    if (bus_state.hardware_error[j] != last_hardware_error[j])
+                    {
+                        RT_LOG_ERROR("Hardware_Error_Status 0x%02x on joint %zu", (unsigned int)bus_state.hardware_error[j], j);
+                    }
+                }
+                last_hardware_error[j] = bus_state.hardware_error[j];
+            }
+        }
+        bus_state.cycle = bus_cycle++;
+        bus_state.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count();
+
+        StateFrame *slot = state_ring.acquire();
+        if (slot == nullptr)
+        {
+            // publisher is behind, the bus keeps its cadence
+            dropped_state_frames++;
+            return;
+        }
+        *slot = bus_state;
+        state_ring.publish();
+    };
+
+    auto bus_write = [&]()
+    {
+        // take the latest command
+        bool has_command = false;
+        while (CommandFrame *slot = command_ring.front())
+        {
+            bus_command = *slot;
+            command_ring.pop();
+            has_command = true;
+        }
+
+        if (has_command)
+        {
+            if (apply_position_gains)
+            {
+                di.setGain("Position_P_Gain", bus_command.position_p_gain);
+                di.setGain("Position_D_Gain", bus_command.position_d_gain);
+            }
+            if (apply_velocity_gains)
+            {
+                di.setGain("Velocity_P_Gain", bus_command.velocity_p_gain);
+            }
+            if (ss.jointType & ShmSettings::JointType::PositionCommand)
+            {
+                di.setGoal("Goal_Position", bus_command.position);
+            }
+            if (ss.jointType & ShmSettings::JointType::VelocityCommand)
+            {
+                di.setGoal("Goal_Velocity", bus_command.velocity);
+            }
+            if (ss.jointType & ShmSettings::JointType::TorqueCommand)
+            {
+                di.setGoal("Goal_Current", bus_command.current);
+            }
+        }
+
+        // write gains to Dynamixel (only groups where they changed)
+        int64_t write_start = CycleScheduler::now();
+        bus_write_flags = 0;
+        if (!di.writeGains())
+        {
+            bus_write_flags |= STATE_GAIN_WRITE_FAILED;
+        }
+        // write comand value to Dynamixel (one packet for each group and mode)
+        if (!di.writeGoals())
+        {
+            bus_write_flags |= STATE_GOAL_WRITE_FAILED;
+        }
+        write_ns = CycleScheduler::now() - write_start;
+        loop_status.updateTransactions(read_ns, auxiliary_ns, write_ns);
+    };
+
+    // publisher side: unit conversion and shered memory
+    // (DynamixelInterface is only used for the read-only conversions here)
+    auto publish = [&]() -> bool
+    {
+        StateFrame *state = state_ring.front();
+        if (state == nullptr)
+        {
+            return false;
+        }
+
         // convert to floating value
-        di.convertPosition(cur_pos_vec, cur_pos_float_vec);
-        di.convertVelocity(cur_vel_vec, cur_vel_float_vec);
-        // di.convertCurrent(cur_cur_vec, cur_cur_float_vec);
-        di.convertTorque(cur_cur_vec, cur_torque_float_vec);
+        di.convertPosition(state->position, cur_pos_float_vec);
+        di.convertVelocity(state->velocity, cur_vel_float_vec);
+        if (publish_current)
+        {
+            di.convertCurrentAndTorque(state->current, cur_cur_float_vec, cur_torque_float_vec);
+        }
+        else
+        {
+            di.convertTorque(state->current, cur_torque_float_vec);
+        }
+        if (publish_temperature)
+        {
+            di.convertTemperature(state->temperature, cur_temp_float_vec);
+        }
 
         // write to sheread memory
         sm.writePositionCurrent(cur_pos_float_vec);
         sm.writeVelocityCurrent(cur_vel_float_vec);
         sm.writeTorqueCurrent(cur_torque_float_vec);
+        if (publish_current)
+        {
+            sm.writeMotorCurrent(cur_cur_float_vec);
+        }
+        if (publish_temperature)
+        {
+            sm.writeMotorTemperature(cur_temp_float_vec);
+        }
 
-        if (ss.jointType & ShmSettings::JointType::PositionCommand)
+        CommandFrame *command = command_ring.acquire();
+        if (command == nullptr)
         {
-            // read command value from shered memory
-            sm.readPositionCommand(cmd_pos_float_vec);
-            // write comand value to Dynamixel
-            di.convertPositionCmd(cmd_pos_float_vec, dynamixel_position);
-            di.writePosition(dynamixel_position);
+            dropped_command_frames++;
         }
-        else if (ss.jointType & ShmSettings::JointType::VelocityCommand)
+        else
         {
-            // read command value from shered memory
-            sm.readVelocityCommand(cmd_vel_float_vec);
-            // write comand value to Dynamixel
-            di.convertVelocityCmd(cmd_vel_float_vec, dynamixel_velocity);
-            di.writeVelocity(dynamixel_velocity);
+            command->cycle = state->cycle;
+            if (apply_position_gains)
+            {
+                sm.readPGain(gain_p_float_vec);
+                di.convertGainCmd(gain_p_float_vec, command->position_p_gain);
+                sm.readDGain(gain_d_float_vec);
+                di.convertGainCmd(gain_d_float_vec, command->position_d_gain);
+            }
+            if (apply_velocity_gains)
+            {
+                sm.readVelocityPGain(gain_p_float_vec);
+                di.convertGainCmd(gain_p_float_vec, command->velocity_p_gain);
+            }
+
+            if (ss.jointType & ShmSettings::JointType::PositionCommand)
+            {
+                if (use_trajectory && trajectory.evaluate(TrajectoryBuffer::now(), goal_pos_float_vec))
+                {
+                    // evaluate the trajectory streamed by the client
+                    di.convertPositionCmd(goal_pos_float_vec, command->position);
+                    trajectory_active = true;
+                }
+                else
+                {
+                    if (trajectory_active)
+                    {
+                        // the trajectory was released, the shered memory command continues from its final position
+                        sm.writePositionCommand(goal_pos_float_vec);
+                        interpolator.reset(goal_pos_float_vec);
+                        trajectory_active = false;
+                    }
+                    // read command value from shered memory
+                    sm.readPositionCommand(cmd_pos_float_vec);
+                    // interpolate between controller updates
+                    interpolator.update(cmd_pos_float_vec, goal_pos_float_vec);
+                    di.convertPositionCmd(goal_pos_float_vec, command->position);
+                }
+            }
+            if (ss.jointType & ShmSettings::JointType::VelocityCommand)
+            {
+                // read command value from shered memory
+                sm.readVelocityCommand(cmd_vel_float_vec);
+                di.convertVelocityCmd(cmd_vel_float_vec, command->velocity);
+            }
+            if (ss.jointType & ShmSettings::JointType::TorqueCommand)
+            {
+                // read command value from shered memory
+                sm.readTorqueCommand(cmd_torque_float_vec);
+                di.convertTorqueCmd(cmd_torque_float_vec, command->current);
+            }
         }
 
+        if (recorder.isOpen())
+        {
+            if (command != nullptr)
+            {
+                last_command = *command;
+            }
+            recorder.record(sm.getFrame(), *state,
+                            cur_pos_float_vec, cur_vel_float_vec, cur_torque_float_vec,
+                            last_command,
+                            goal_pos_float_vec, cmd_vel_float_vec, cmd_torque_float_vec);
+        }
+        if (command != nullptr)
+        {
+            command_ring.publish();
+        }
+        int64_t timestamp_ns = state->timestamp_ns;
+        state_ring.pop();
+
         if (verbose)
         {
             status_print(cur_pos_float_vec, cur_vel_float_vec);
-            std::cout << "--------------------" << std::endl;
+            RealtimeLogger::instance().log(RealtimeLogger::Out, "--------------------");
         }
 
+        sm.incrementFrame();
+        loop_status.updateFrame(sm.getFrame(), timestamp_ns);
+        // wake the consumers blocked on the new frame (in lockstep, the controller computes the next command)
+        loop_status.signalState();
+        return true;
+    };
+
+    // console output of the running loop is written by a background thread
+    RealtimeLogger::instance().start();
+
+    std::atomic<bool> running(true);
+    std::thread publisher_thread;
+    if (use_publisher_thread)
+    {
+        // commands reach the bus one cycle later, but the bus cadence no longer
+        // depends on shered memory consumers or console output
+        publisher_thread = std::thread([&]()
+        {
+            while (running.load(std::memory_order_relaxed))
+            {
+                if (!publish())
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+        });
+    }
+
+    tm.start();
+    scheduler.start();
+    int64_t window_start = CycleScheduler::now();
+    // the segment starts from 0, so commands signaled before the loop starts are not missed
+    uint32_t command_sequence = 0;
+    while (true)
+    {
+        if (lockstep && !loop_status.waitCommand(command_sequence, LOCKSTEP_TIMEOUT_NS))
+        {
+            continue;
+        }
+        cycle_flags = scheduler.wait() ? 0u : (uint32_t)STATE_OVERRUN;
+        tm.sync();
+        loop_status.update(scheduler.getStatistics());
+
+        bus_read();
+        if (!use_publisher_thread)
+        {
+            publish();
+        }
+        bus_write();
+
         cntr++;
 
-        sm.incrementFrame();
         if (cntr > 100)
         {
-            std::cout << "max: " << tm.getMaxInterval() << std::endl;
+            RealtimeLogger::instance().log(RealtimeLogger::Out, "max: %g", (double)tm.getMaxInterval());
+            int64_t window_end = CycleScheduler::now();
+            int64_t mean_cycle_ns = (window_end - window_start) / cntr;
+            window_start = window_end;
+            loop_status.updateCycleTime(mean_cycle_ns);
+            if (free_run)
+            {
+                RealtimeLogger::instance().log(RealtimeLogger::Out, "free run: %g [Hz] (read %g, auxiliary %g, write %g [usec])",
+                                               1e9 / mean_cycle_ns, read_ns / 1000.0, auxiliary_ns / 1000.0, write_ns / 1000.0);
+            }
+            const WakeHistogram &wake = scheduler.getWakeHistogram();
+            if (wake.samples > 0)
+            {
+                RealtimeLogger::instance().log(RealtimeLogger::Out, "wake latency [usec]: p50 %g, p99 %g, max %g",
+                                               wake.quantile(0.5) / 1000.0, wake.quantile(0.99) / 1000.0, wake.max_ns / 1000.0);
+                scheduler.resetWakeHistogram();
+            }
+            const CycleStatistics &cycle_statistics = scheduler.getStatistics();
+            if (cycle_statistics.overruns > 0)
+            {
+                RealtimeLogger::instance().log(RealtimeLogger::Out, "overruns: %llu (worst %lld [usec], max streak %llu, skipped %llu)",
+                                               (unsigned long long)cycle_statistics.overruns,
+                                               (long long)(cycle_statistics.worst_overrun_ns / 1000),
+                                               (unsigned long long)cycle_statistics.max_miss_streak,
+                                               (unsigned long long)cycle_statistics.skipped_cycles);
+            }
+            if (dropped_state_frames > 0 || dropped_command_frames > 0)
+            {
+                RealtimeLogger::instance().log(RealtimeLogger::Out, "dropped frames (state/command): %llu/%llu",
+                                               (unsigned long long)dropped_state_frames,
+                                               (unsigned long long)dropped_command_frames.load());
+            }
             tm.reset();
             cntr = 0;
         }
     }
+    running = false;
+    if (publisher_thread.joinable())
+    {
+        publisher_thread.join();
+    }
+    RealtimeLogger::instance().stop();
     // polling
 
     return 0;